@@ -0,0 +1,128 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_ALIGNEDALLOCATOR_H__
+#define __BSPLIB_ALIGNEDALLOCATOR_H__
+
+#include "bsp/util.h"
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace BSPInternal
+{
+    /**
+     * An allocator that aligns its allocations on the given alignment. The default allocator does not respect the
+     * alignment of over-aligned types before C++17, which we need to keep the data of every processor on its own
+     * cache lines.
+     *
+     * @tparam  tType       The type to allocate.
+     * @tparam  tAlignment  The alignment in bytes, a power of two.
+     */
+
+    template< typename tType, size_t tAlignment = BSP_CACHE_LINE_SIZE >
+    class AlignedAllocator
+    {
+    public:
+
+        typedef tType value_type;
+
+        template< typename tOther >
+        struct rebind
+        {
+            typedef AlignedAllocator< tOther, tAlignment > other;
+        };
+
+        AlignedAllocator()
+        {
+        }
+
+        template< typename tOther >
+        AlignedAllocator(const AlignedAllocator< tOther, tAlignment > &)
+        {
+        }
+
+        tType *allocate(size_t count)
+        {
+            const size_t alignment = alignof(tType) > tAlignment ? alignof(tType) : tAlignment;
+            void *memory = nullptr;
+
+#ifdef _WIN32
+            memory = _aligned_malloc(count * sizeof(tType), alignment);
+#else
+
+            if (posix_memalign(&memory, alignment, count * sizeof(tType)) != 0)
+            {
+                memory = nullptr;
+            }
+
+#endif
+
+            if (!memory)
+            {
+                throw std::bad_alloc();
+            }
+
+            return static_cast<tType *>(memory);
+        }
+
+        void deallocate(tType *memory, size_t)
+        {
+#ifdef _WIN32
+            _aligned_free(memory);
+#else
+            free(memory);
+#endif
+        }
+
+        template< typename tOther >
+        bool operator==(const AlignedAllocator< tOther, tAlignment > &) const
+        {
+            return true;
+        }
+
+        template< typename tOther >
+        bool operator!=(const AlignedAllocator< tOther, tAlignment > &) const
+        {
+            return false;
+        }
+    };
+
+    /**
+     * A vector of which the elements start on a cache line.
+     */
+
+    template< typename tType >
+    using CacheAlignedVector = std::vector< tType, AlignedAllocator< tType > >;
+}
+
+#endif
@@ -28,6 +28,7 @@
 #define __BSPLIB_BARRIER_H__
 
 #include "bsp/bspAbort.h"
+#include "bsp/util.h"
 
 namespace BSPInternal
 {
@@ -51,6 +52,8 @@ namespace BSPInternal
             mSpaces(count),
             mGeneration(0)
         {
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -66,6 +69,8 @@ namespace BSPInternal
             mCount = count;
             mSpaces = count;
             mGeneration = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -80,12 +85,40 @@ namespace BSPInternal
          */
 
         void Wait(const std::atomic_bool &aborted)
+        {
+            Wait(aborted, 0);
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, and combines the flags every thread arrives with. The flags
+         * of a generation are kept until the next generation has been completed, so every thread can read them after
+         * it has been released.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param           flags   The flags this thread arrives with.
+         * @param           id      The identifier of the waiting thread, not needed by this barrier.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t flags, uint32_t /*id*/ = 0)
         {
             const uint32_t myGeneration = mGeneration;
+            std::atomic_uint_fast32_t &generationFlags = mFlags[myGeneration & 1];
+
+            if (flags)
+            {
+                generationFlags |= flags;
+            }
 
             if (!--mSpaces)
             {
                 mSpaces = mCount;
+                mFlags[(myGeneration + 1) & 1] = 0;
                 ++mGeneration;
             }
             else
@@ -96,8 +129,12 @@ namespace BSPInternal
                     {
                         throw BspAbort("Aborted");
                     }
+
+                    BSPUtil::Pause();
                 }
             }
+
+            return static_cast<uint32_t>(generationFlags);
         }
 
         void NotifyAbort()
@@ -110,11 +147,15 @@ namespace BSPInternal
         /// The amount of threads to wait for in total
         uint32_t mCount;
 
-        /// The amount of threads filling the barrier currently
-        std::atomic_uint_fast32_t mSpaces;
+        /// The amount of threads filling the barrier currently, written by every arriving thread
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mSpaces;
+
+        /// The combined flags of the current and the previous generation
+        std::atomic_uint_fast32_t mFlags[2];
 
-        /// The current waiting generation, so we can reuse the barrier
-        std::atomic_uint_fast32_t mGeneration;
+        /// The current waiting generation, so we can reuse the barrier. On its own cache line, since the waiting
+        /// threads spin on it.
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mGeneration;
     };
 }
 
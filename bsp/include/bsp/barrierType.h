@@ -29,6 +29,8 @@
 
 #include "bsp/condVarBarrier.h"
 #include "bsp/mixedBarrier.h"
+#include "bsp/futexBarrier.h"
+#include "bsp/treeBarrier.h"
 #include "bsp/barrier.h"
 
 #ifndef BSP_BARRIER_TYPE
@@ -31,6 +31,7 @@
 #   define BSP_SKIP_CHECKS
 #endif
 
+#include "bsp/collectives.h"
 #include "bsp/bspExt.h"
 
 #ifndef BSP_DISABLE_NAMESPACE
@@ -35,6 +35,10 @@
 #include "bsp/processorData.h"
 #include "bsp/requestVector.h"
 #include "bsp/mixedBarrier.h"
+#include "bsp/messageView.h"
+#include "bsp/threadPlacement.h"
+#include "bsp/splitBarrier.h"
+#include "bsp/workerPool.h"
 #include "bsp/barrier.h"
 #include "bsp/util.h"
 
@@ -43,7 +47,9 @@
 #include <iterator>
 #include <stdarg.h>
 #include <valarray>
+#include <cstring>
 #include <atomic>
+#include <limits>
 #include <future>
 #include <map>
 
@@ -154,21 +160,19 @@ public:
         assert(packets != nullptr);
 #endif
 
-        *packets = 0;
+        const ProcessorData &data = mProcessorsData[ProcId()];
+        *packets = data.sendRequestsSize;
 
         if (accumulatedSize)
         {
             *accumulatedSize = 0;
-        }
-
-        const BSPInternal::RequestVector< BSPInternal::SendRequest > &sendQueue = mProcessorsData[ProcId()].sendRequests;
-        *packets += sendQueue.GetSize();
 
-        if (accumulatedSize)
-        {
-            for (auto request = sendQueue.CBegin(), end = sendQueue.CEnd(); request != end; ++request)
+            for (const BSPInternal::SendSegment &segment : data.sendSegments)
             {
-                *accumulatedSize += request->bufferSize;
+                for (auto request = segment.requests->CBegin(), end = segment.requests->CEnd(); request != end; ++request)
+                {
+                    *accumulatedSize += request->bufferSize;
+                }
             }
         }
     }
@@ -234,7 +238,6 @@ public:
 
     inline void Init(std::function< void() > entry, int32_t, char **)
     {
-        mEntry = entry;
         mTagSize = 0;
 
         if (!mEnded && !mAbort)
@@ -254,6 +257,20 @@ public:
 #   endif
 #endif
 
+            uint32_t poolCount = 0;
+
+            while (!mWorkerPool.WaitFor(std::chrono::milliseconds(200)) && poolCount++ < 100)
+            {
+                mThreadBarrier.NotifyAbort();
+                mSplitBarrier.NotifyAbort();
+            }
+
+            if (poolCount >= 100)
+            {
+                fprintf(stderr, "Error: could not safely end the previous BSP program. Terminating now.");
+                std::terminate();
+            }
+
             for (auto &thr : mThreads)
             {
 #ifndef BSP_SUPPRESS_ABORT_WARNING
@@ -266,6 +283,7 @@ public:
                 while (thr.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout && count++ < 100)
                 {
                     mThreadBarrier.NotifyAbort();
+                    mSplitBarrier.NotifyAbort();
                 }
 
                 if (count >= 100)
@@ -284,9 +302,176 @@ public:
             }
         }
 
+        mEntry = entry;
         ProcId() = 0;
     }
 
+    /**
+     * Sets whether the worker threads are kept alive between BSP programs. Persistent workers park after End, and
+     * the next Begin only dispatches the entry point to them, instead of starting new threads.
+     *
+     * @param   persistent Whether the workers should be persistent.
+     *
+     * @pre No BSP program is running.
+     *
+     * @post If persistent is false, the parked workers have been stopped.
+     */
+
+    inline void SetPersistentWorkers(bool persistent)
+    {
+        mPersistentWorkers = persistent;
+
+        if (!persistent)
+        {
+            mWorkerPool.Stop();
+        }
+    }
+
+    /**
+     * Sets the policy to place the processors on the CPUs, overriding the `BSP_PLACEMENT` environment variable.
+     *
+     * @param   placement The placement policy.
+     *
+     * @pre No BSP program is running.
+     */
+
+    inline void SetPlacement(BSPInternal::Placement placement)
+    {
+        mPlacement.SetPolicy(placement);
+    }
+
+    /**
+     * Places processor `i` on the CPU at `cpus[i % cpus.size()]`, overriding the `BSP_PLACEMENT` environment variable.
+     *
+     * @param   cpus The CPUs to place the processors on.
+     *
+     * @pre No BSP program is running.
+     */
+
+    inline void SetPlacement(const std::vector< uint32_t > &cpus)
+    {
+        mPlacement.SetExplicit(cpus);
+    }
+
+    /**
+     * Sets the policy that sizes the buffers and queues of the processors. The new sizes are reserved by the next
+     * Begin.
+     *
+     * @param   policy The buffer policy.
+     *
+     * @pre No BSP program is running.
+     */
+
+    inline void SetBufferPolicy(const BSPInternal::BufferPolicy &policy)
+    {
+        BSPInternal::GetBufferPolicy() = policy;
+    }
+
+    /**
+     * Reserves the queues and buffers of the current processor for the communication it issues to the given
+     * processor in every superstep, so issuing at most that volume does not allocate. The reserved memory is kept
+     * until the end of the BSP program, and a new reservation to the same processor replaces the previous one.
+     *
+     * @param   pid    The processor to communicate with.
+     * @param   volume The communication volume, where the bytes of the sends exclude their tags.
+     *
+     * @pre Begin has been called.
+     */
+
+    inline void ReserveCommunication(uint32_t pid, BSPInternal::CommunicationVolume volume)
+    {
+        const uint32_t tpid = ProcId();
+
+#ifndef BSP_SKIP_CHECKS
+        assert(pid < mProcCount);
+        assert(tpid < mProcCount);
+#endif
+
+        volume.sendBytes += volume.sends * mTagSize;
+        mProcessorsData[tpid].Reserve(pid, mProcCount, volume);
+    }
+
+    /**
+     * Begins a collective operation by publishing the data of the current processor, and waiting until all processors
+     * have published theirs. Afterwards, the data of every processor can be read directly with CollectiveData. Data of
+     * at most CollectiveSlot::InlineCapacity bytes is copied, so it may be changed immediately; larger data is
+     * published by reference, and must not change until EndCollective.
+     *
+     * @param   data The data of the current processor.
+     * @param   size The size of the data in bytes, or a size larger than the inline capacity to publish by reference.
+     *
+     * @return Whether the data was published by reference.
+     *
+     * @pre
+     *  * All processors begin the same collectives in the same order, with the same size.
+     *  * The previous collective has ended.
+     */
+
+    inline bool BeginCollective(const void *data, size_t size)
+    {
+        ProcessorData &processor = mProcessorsData[ProcId()];
+
+#ifndef BSP_SKIP_CHECKS
+        assert(!processor.syncPending);
+#endif
+
+        BSPInternal::CollectiveSlot &slot = processor.collectiveSlots[processor.collectiveSet];
+        const bool byReference = size > BSPInternal::CollectiveSlot::InlineCapacity;
+
+        if (byReference)
+        {
+            slot.data = data;
+        }
+        else
+        {
+            memcpy(slot.bytes, data, size);
+            slot.data = slot.bytes;
+        }
+
+        SyncPoint();
+
+        return byReference;
+    }
+
+    /**
+     * Gets the data the given processor published in the current collective operation.
+     *
+     * @param   pid The processor that published the data.
+     *
+     * @return The published data.
+     *
+     * @pre BeginCollective has been called.
+     */
+
+    inline const void *CollectiveData(uint32_t pid)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(pid < mProcCount);
+#endif
+
+        return mProcessorsData[pid].collectiveSlots[mProcessorsData[ProcId()].collectiveSet].data;
+    }
+
+    /**
+     * Ends the collective operation of the current processor. Data published by reference is read directly by the
+     * other processors, so then all processors wait until everyone has finished reading. Copied data is not waited
+     * for, since the next collective publishes into the other slot, and the one after that cannot begin before all
+     * processors have reached the next barrier.
+     *
+     * @param   byReference Whether the data was published by reference, as returned by BeginCollective.
+     */
+
+    inline void EndCollective(bool byReference)
+    {
+        if (byReference)
+        {
+            SyncPoint();
+        }
+
+        uint32_t &collectiveSet = mProcessorsData[ProcId()].collectiveSet;
+        collectiveSet = 1 - collectiveSet;
+    }
+
     /**
      * Begins the computations with the maximum given processors.
      *
@@ -316,23 +501,12 @@ public:
             ProcId() = 0;
         }
 
-#ifdef _WIN32
-        SetThreadAffinityMask(GetCurrentThread(), 1 << (ProcId() % std::thread::hardware_concurrency()));
-        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-#endif // _WIN32
-
-#if defined(__GNUC__) && !defined(__APPLE__)
-        int num_cores = std::thread::hardware_concurrency();
-        int core_id = ProcId() % num_cores;
-
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(core_id, &cpuset);
-
-        pthread_t current_thread = pthread_self();
-        pthread_setaffinity_np(current_thread, sizeof(cpu_set_t), &cpuset);
-#endif
+        if (ProcId() == 0)
+        {
+            mPlacement.Prepare();
+        }
 
+        mPlacement.Pin(ProcId());
 
         if (ProcId())
         {
@@ -348,6 +522,8 @@ public:
             assert(ProcId() < maxProcs);
 #endif
 
+            mProcessorsData[ProcId()].Allocate(maxProcs);
+
             StartTiming();
             mHistoryRecorder.InitSyncTimer(ProcId());
             return;
@@ -357,31 +533,36 @@ public:
         mEnded = false;
         mProcCount = maxProcs;
 
-        mProcessorsData.clear();
-        mProcessorsData.resize(maxProcs);
-
-        for (uint32_t i = 0; i < maxProcs; ++i)
+        if (mProcessorsData.size() == maxProcs)
+        {
+            // Reuse the buffers and queues of the previous program, so they are still allocated and warm
+            for (ProcessorData &data : mProcessorsData)
+            {
+                data.Reset();
+            }
+        }
+        else
         {
-            ProcessorData &data = mProcessorsData[i];
-            data.putRequests.resize(maxProcs);
-            data.getRequests.resize(maxProcs);
-            data.bufferedGetRequests.resize(maxProcs);
-            data.tmpSendRequests.resize(maxProcs);
-            data.tmpSendBufferStacks.resize(maxProcs);
+            mProcessorsData.clear();
+            mProcessorsData.resize(maxProcs);
         }
 
+        // Every processor allocates its own buffers and queues, so they are placed on its own NUMA node
+        mProcessorsData[0].Allocate(maxProcs);
+
         mThreadBarrier.SetSize(maxProcs);
+        mSplitBarrier.SetSize(maxProcs);
 
         mThreads.clear();
         mThreads.reserve(maxProcs);
 
         mHistoryRecorder.ResetResize(maxProcs);
 
-        for (uint32_t i = 1; i < mProcCount; ++i)
+        if (mPersistentWorkers)
         {
-            mThreads.emplace_back(std::async(std::launch::async, [this](uint32_t pid)
+            mWorkerPool.Run(mProcCount - 1, [this](uint32_t worker)
             {
-                ProcId() = pid;
+                ProcId() = worker + 1;
 
                 try
                 {
@@ -391,7 +572,26 @@ public:
                 {
 
                 }
-            }, i));
+            });
+        }
+        else
+        {
+            for (uint32_t i = 1; i < mProcCount; ++i)
+            {
+                mThreads.emplace_back(std::async(std::launch::async, [this](uint32_t pid)
+                {
+                    ProcId() = pid;
+
+                    try
+                    {
+                        mEntry();
+                    }
+                    catch (BSPInternal::BspAbort &)
+                    {
+
+                    }
+                }, i));
+            }
         }
 
         StartTiming();
@@ -417,6 +617,8 @@ public:
 
         if (ProcId() == 0)
         {
+            mWorkerPool.Wait();
+
             for (auto &thr : mThreads)
             {
                 if (thr.valid())
@@ -434,12 +636,30 @@ public:
 
     inline void SyncPoint()
     {
-        mThreadBarrier.Wait(mAbort);
+        mThreadBarrier.Wait(mAbort, 0, ProcId());
+    }
+
+    /**
+     * Waits for all threads to reach the sync point, and combines the given flags of all threads.
+     *
+     * @param   flags The flags of this thread.
+     *
+     * @return The flags of all threads combined with a bitwise or.
+     */
+
+    inline uint32_t SyncPoint(uint32_t flags)
+    {
+        return mThreadBarrier.Wait(mAbort, flags, ProcId());
     }
 
     /**
      * Synchronises all threads and communications.
      *
+     * The requests every processor has pending are combined in the first barrier of the sync. Supersteps that only
+     * communicated with puts, gets, sends or a tag size update do not need a closing barrier, since their queues and
+     * buffers are double buffered, or only cleared by their owner in the next sync. An empty superstep thus costs a
+     * single barrier.
+     *
      * @pre Begin has been called
      *
      * @post
@@ -456,90 +676,102 @@ public:
     {
         CheckAborted();
         uint32_t &pid = ProcId();
+
+#ifndef BSP_SKIP_CHECKS
+        assert(!mProcessorsData[pid].syncPending);
+#endif
+
         mHistoryRecorder.RecordPreSync(pid);
 
+        ProcessSync(pid, SyncPoint(CollectSyncFlags(pid)));
+    }
+
+    /**
+     * Begins a split phase sync, by publishing the requests of the current processor without waiting for the other
+     * processors. The processor can then do local work, while the others arrive at the sync. Once all processors
+     * have arrived, the processors that already wait in SyncEnd deliver the puts and sends to the processors that
+     * are still doing their local work.
+     *
+     * @pre
+     *  * Begin has been called.
+     *  * All processors begin this sync with SyncBegin.
+     *  * Until SyncEnd, the processor does not communicate or read its received messages, does not change the
+     *    memory that is the source of gets from other processors, or of its own unbuffered puts, and does not use the
+     *    registers that receive data in this sync.
+     */
+
+    inline void SyncBegin()
+    {
+        CheckAborted();
+        uint32_t &pid = ProcId();
         ProcessorData &data = mProcessorsData[pid];
-        auto &syncBools = data.syncBools;
 
-        CheckSyncBools(pid);
+#ifndef BSP_SKIP_CHECKS
+        assert(!data.syncPending);
+#endif
 
-        SyncPoint();
-        mHistoryRecorder.RecordProcessorsData(pid, mProcessorsData);
+        mHistoryRecorder.RecordPreSync(pid);
 
-        bool anySync = CollectSyncBools(pid);
+        data.syncGeneration = mSplitBarrier.Arrive(CollectSyncFlags(pid));
+        data.syncPending = true;
+    }
 
-        if (syncBools.hasTagSizeUpdate)
-        {
-            //printf( "%d updates tagsize\n", pid );
-            ProcessTagSizeUpdate(pid);
-        }
+    /**
+     * Ends a split phase sync, by waiting until all processors have begun the sync, and delivering the communication
+     * as Sync does. When the sync only carries puts and sends, their delivery needs no further barriers, so the
+     * processor also delivers them for the processors that have not reached SyncEnd yet.
+     *
+     * @pre SyncBegin has been called.
+     *
+     * @post The same as for Sync.
+     */
 
-        if (syncBools.hasGetRequests)
-        {
-            //printf( "%d buffers get\n", pid );
-            BufferGetRequests(pid);
-        }
+    inline void SyncEnd()
+    {
+        uint32_t &pid = ProcId();
+        ProcessorData &data = mProcessorsData[pid];
 
-        if (syncBools.hasTagSizeUpdate || syncBools.hasGetRequests)
-        {
-            //printf( "%d syncs tagsize or get\n", pid );
-            SyncPoint();
-        }
+#ifndef BSP_SKIP_CHECKS
+        assert(data.syncPending);
+#endif
 
-        if (syncBools.hasPopRequests)
-        {
-            //printf( "%d processes pop\n", pid );
-            ProcessPopRequests(pid);
-        }
+        const uint32_t generation = data.syncGeneration;
+        const uint32_t syncFlags = mSplitBarrier.Wait(mAbort, generation);
+        const uint32_t deliveredFlags = BSPInternal::PutRequestsFlag | BSPInternal::SendRequestsFlag;
+        data.syncPending = false;
 
-        if (syncBools.hasSendRequests)
+        if (!(syncFlags & deliveredFlags) || (syncFlags & ~deliveredFlags) || mHistoryRecorder.RecordsProcessorsData())
         {
-            //printf( "%d processes send\n", pid );
-            ProcessSendRequests(pid);
+            ProcessSync(pid, syncFlags);
+            return;
         }
 
-        if (syncBools.hasPutRequests)
+        // Starting with ourselves, so we are not kept waiting for a processor that is still working
+        for (uint32_t i = 0; i < mProcCount; ++i)
         {
-            //printf( "%d processes put\n", pid );
-            ProcessPutRequests(pid);
-        }
+            const uint32_t target = (pid + i) % mProcCount;
 
-        if (syncBools.hasGetRequests)
-        {
-            //printf( "%d processes get\n", pid );
-            ProcessGetRequests(pid);
+            if (mSplitBarrier.ClaimDelivery(target, generation))
+            {
+                DeliverSplitSync(target, syncFlags);
+                mSplitBarrier.CompleteDelivery(target, generation);
+            }
         }
 
-        if (syncBools.hasSendRequests || syncBools.hasPopRequests || syncBools.hasPutRequests || syncBools.hasGetRequests)
-        {
-            //printf( "%d enters massive sync\n", pid );
-            SyncPoint();
-        }
+        mSplitBarrier.WaitDelivery(mAbort, pid, generation);
 
-        if (syncBools.hasSendRequests)
+        if (syncFlags & BSPInternal::SendRequestsFlag)
         {
-            //printf( "%d clears send\n", pid );
             ClearSendRequests(pid);
         }
-
-        if (syncBools.hasPutRequests)
-        {
-            //printf( "%d clears put\n", pid );
-            data.putBufferStack.Clear();
-        }
-
-        if (syncBools.hasPushRequests)
+        else if (data.sendRequestsSize)
         {
-            //printf( "%d processes push\n", pid );
-            ProcessPushRequests(pid);
-            SyncPoint();
+            ClearReceivedMessages(pid);
         }
 
-        ResetBools(pid);
-
-        if (!anySync)
+        if (syncFlags & BSPInternal::PutRequestsFlag)
         {
-            SyncPoint();
+            ClearPutBuffer(pid);
         }
 
         mHistoryRecorder.RecordPostSync(pid);
@@ -555,10 +787,11 @@ public:
         mHistoryRecorder.RecordProcessorsData(pid, mProcessorsData);
 
         ProcessPutRequests(pid);
+        ProcessHPPutRequests(pid);
 
         SyncPoint();
 
-        mProcessorsData[pid].putBufferStack.Clear();
+        ClearPutBuffer(pid);
 
         mHistoryRecorder.RecordPostSync(pid);
     }
@@ -573,6 +806,7 @@ public:
         mHistoryRecorder.RecordProcessorsData(pid, mProcessorsData);
 
         BufferGetRequests(pid);
+        ProcessHPGetRequests(pid);
 
         SyncPoint();
 
@@ -607,24 +841,44 @@ public:
      *
      * @pre Begin has been called.
      *
+     * @return The global ID of the register.
+     *
      * @post
      *  * Push request has been queued.
      *  * In the next superstep, this register will be available for Put/Get.
      */
 
-    void PushReg(const void *ident, size_t size)
+    uint32_t PushReg(const void *ident, size_t size)
     {
         uint32_t &pid = ProcId();
 
 #ifndef BSP_SKIP_CHECKS
         assert(pid < mProcCount);
         assert(mProcessorsData.size() > pid);
+        assert(!mProcessorsData[pid].syncPending);
 #endif
 
-        BSPInternal::PushRequest &pushRequest = mProcessorsData[pid].pushRequests.InitRequest();
+        ProcessorData &data = mProcessorsData[pid];
+        BSPInternal::PushRequest &pushRequest = data.pushRequests.InitRequest();
         pushRequest.pushRegister = ident;
         pushRequest.registerInfo.size = (uint32_t)size;
-        pushRequest.registerInfo.registerCount = mProcessorsData[pid].registerCount++;
+
+        if (data.freeRegisters.empty())
+        {
+#ifndef BSP_SKIP_CHECKS
+            // The top bits of the global IDs in the put requests mark inline payloads
+            assert(data.registerCount < BSPInternal::PutRequest::IdMask);
+#endif
+
+            pushRequest.registerInfo.registerCount = data.registerCount++;
+        }
+        else
+        {
+            pushRequest.registerInfo.registerCount = data.freeRegisters.back();
+            data.freeRegisters.pop_back();
+        }
+
+        return pushRequest.registerInfo.registerCount;
     }
 
     /**
@@ -646,10 +900,12 @@ public:
 #ifndef BSP_SKIP_CHECKS
         assert(pid < mProcCount);
         assert(mProcessorsData.size() > pid);
+        assert(!mProcessorsData[pid].syncPending);
 #endif
 
         BSPInternal::PopRequest &popRequest = mProcessorsData[pid].popRequests.InitRequest();
         popRequest.popRegister = ident;
+        popRequest.globalId = (uint32_t)(-1);
     }
 
     /**
@@ -671,31 +927,153 @@ public:
      */
 
     BSP_FORCEINLINE void Put(uint32_t pid, const void *src, void *dst, ptrdiff_t offset, size_t nbytes)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(ProcId() < mProcCount);
+        assert(dst);
+#endif
+
+        PutRegister(pid, src, mProcessorsData[ProcId()].threadRegisters.LocalToGlobal(dst), offset, nbytes);
+    }
+
+    /**
+     * Puts a buffer of size nbytes from source pointer src in the thread with ID pid at offset from the register with
+     * the given global ID, as returned by PushReg.
+     *
+     * @param   pid         The processor ID.
+     * @param   src         Source to read the buffer from.
+     * @param   globalId    The global ID of the destination register.
+     * @param   offset      The offset from the destination to start writing at.
+     * @param   nbytes      The size of the message to be written to the other processor.
+     *
+     * @pre
+     * * Begin has been called.
+     * * src != nullptr.
+     * * The register has been pushed with at least size offset + nbytes in the processor with ID pid.
+     * * A Sync has happened between PushReg and this call.
+     */
+
+    BSP_FORCEINLINE void PutRegister(uint32_t pid, const void *src, uint32_t globalId, ptrdiff_t offset, size_t nbytes)
     {
         uint32_t &tpid = ProcId();
         mHistoryRecorder.InitCommunication(tpid);
-        //mHasPutRequests[mProcessorsData[tpid].syncBoolIndex] = true;
 
 #ifndef BSP_SKIP_CHECKS
         assert(tpid < mProcCount);
         assert(pid < mProcCount);
-        assert(src && dst);
+        assert(src);
+        assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
+        assert(!mProcessorsData[tpid].syncPending);
 #endif
 
         const char *srcBuff = reinterpret_cast<const char *>(src);
-        const uint32_t globalId = mProcessorsData[tpid].threadRegisters.LocalToGlobal(dst);
 
-#ifndef BSP_SKIP_CHECKS
-        assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
+        ProcessorData &data = mProcessorsData[tpid];
+        BSPInternal::StackAllocator &putBuffer = data.putBufferStacks[data.putSet];
+        BSPInternal::PutRequestVector &putQueue = data.putRequests[data.putSet][pid];
 
-        /*mThreadRegisterLocation[pid][globalId]*/
-        //assert( mProcessorsData[pid].registers[GlobalToLocal( pid, globalId )].size >= offset + nbytes );
+        if (!MergePut(putQueue, putBuffer, srcBuff, globalId, offset, nbytes))
+        {
+            const uint64_t bufferLocation = static_cast<uint64_t>(putBuffer.Alloc(nbytes, srcBuff));
+
+#ifndef BSP_SKIP_CHECKS
+            assert(offset >= 0 && offset <= std::numeric_limits< uint32_t >::max());
 #endif
 
-        ptrdiff_t bufferLocation = mProcessorsData[tpid].putBufferStack.Alloc(nbytes, srcBuff);
+            putQueue.InitBuffered(globalId, (uint32_t)offset, bufferLocation, (uint32_t)nbytes);
+        }
 
-        auto &putRequest = mProcessorsData[tpid].putRequests[pid].InitRequest();
-        putRequest.bufferLocation = bufferLocation;
+        mHistoryRecorder.FinishCommunication(tpid);
+    }
+
+    /**
+     * Puts a value of a size known at compile time in the thread with ID pid at offset from the register with the
+     * given global ID. Values of at most `PutRequest::InlineCapacity` bytes are stored in the put queue, instead of
+     * in the put buffer, and larger values are buffered with moves of their fixed size.
+     *
+     * @tparam  tSize The size of the value in bytes.
+     *
+     * @param   pid         The processor ID.
+     * @param   src         Source to read the value from.
+     * @param   globalId    The global ID of the destination register.
+     * @param   offset      The offset in bytes from the start of the register to start writing at.
+     *
+     * @pre See PutRegister.
+     */
+
+    template< size_t tSize >
+    BSP_FORCEINLINE void PutFixed(uint32_t pid, const void *src, uint32_t globalId, ptrdiff_t offset)
+    {
+        PutFixed< tSize >(pid, src, globalId, offset,
+                          std::integral_constant< bool, tSize <= BSPInternal::PutRequest::InlineCapacity >());
+    }
+
+    /**
+     * Puts a value of a size known at compile time from source pointer src in the thread with ID pid at destination
+     * pointer dst.
+     *
+     * @tparam  tSize The size of the value in bytes.
+     *
+     * @param   pid         The processor ID.
+     * @param   src         Source to read the value from.
+     * @param [in,out]  dst Destination to write the value to.
+     *
+     * @pre See Put.
+     */
+
+    template< size_t tSize >
+    BSP_FORCEINLINE void PutFixed(uint32_t pid, const void *src, void *dst)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(ProcId() < mProcCount);
+        assert(dst);
+#endif
+
+        PutFixed< tSize >(pid, src, mProcessorsData[ProcId()].threadRegisters.LocalToGlobal(dst), 0);
+    }
+
+    /**
+     * Puts a buffer of size nbytes from source pointer src in the thread with ID pid at offset from destination pointer
+     * dst, without buffering the source. Only the request is recorded; the data is copied directly from src into the
+     * destination register during the next Sync.
+     *
+     * @param   pid         The processor ID.
+     * @param   src         Source to read the buffer from.
+     * @param [in,out]  dst Destination to write the buffer to.
+     * @param   offset      The offset from the destination to start writing at.
+     * @param   nbytes      The size of the message to be written to the other processor.
+     *
+     * @pre
+     * * Begin has been called.
+     * * src != nullptr.
+     * * dst != nullptr.
+     * * Push has been called on dst with at least size offset + nbytes in the processor with ID pid.
+     * * A Sync has happened between PushReg and this call.
+     * * The memory at src remains unchanged until the next Sync has completed.
+     *
+     * @post The order in which unbuffered puts and buffered puts to the same memory are applied is undefined.
+     */
+
+    BSP_FORCEINLINE void HPPut(uint32_t pid, const void *src, void *dst, ptrdiff_t offset, size_t nbytes)
+    {
+        uint32_t &tpid = ProcId();
+        mHistoryRecorder.InitCommunication(tpid);
+
+#ifndef BSP_SKIP_CHECKS
+        assert(tpid < mProcCount);
+        assert(pid < mProcCount);
+        assert(src && dst);
+        assert(!mProcessorsData[tpid].syncPending);
+#endif
+
+        const uint32_t globalId = mProcessorsData[tpid].threadRegisters.LocalToGlobal(dst);
+
+#ifndef BSP_SKIP_CHECKS
+        assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
+#endif
+
+        BSPInternal::HPPutRequest &putRequest = mProcessorsData[tpid].hpPutRequests[pid].InitRequest();
+        putRequest.source = src;
         putRequest.globalId = globalId;
         putRequest.offset = offset;
         putRequest.size = (uint32_t)nbytes;
@@ -722,6 +1100,73 @@ public:
      */
 
     inline void Get(uint32_t pid, const void *src, ptrdiff_t offset, void *dst, size_t nbytes)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(ProcId() < mProcCount);
+        assert(src);
+#endif
+
+        GetRegister(pid, mProcessorsData[ProcId()].threadRegisters.LocalToGlobal(src), offset, dst, nbytes);
+    }
+
+    /**
+     * Gets a buffer of size nbytes from the register with the given global ID, as returned by PushReg, that is located
+     * in the thread with ID pid at offset from the register and stores it at the location of dst.
+     *
+     * @param   pid         The processor ID.
+     * @param   globalId    The global ID of the source register.
+     * @param   offset      The offset from the source to start reading from.
+     * @param [in,out]  dst Destination to write the buffer to.
+     * @param   nbytes      The size of the message to be written in bytes.
+     *
+     * @pre
+     * * Begin has been called.
+     * * dst != nullptr.
+     * * The register has been pushed with at least size offset + nbytes in the processor with ID pid.
+     * * A Sync has happened between PushReg and this call.
+     */
+
+    inline void GetRegister(uint32_t pid, uint32_t globalId, ptrdiff_t offset, void *dst, size_t nbytes)
+    {
+        uint32_t &tpid = ProcId();
+
+#ifndef BSP_SKIP_CHECKS
+        assert(tpid < mProcCount);
+        assert(pid < mProcCount);
+        assert(dst);
+        assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
+        assert(!mProcessorsData[tpid].syncPending);
+#endif
+
+        BSPInternal::GetRequest &getRequest = mProcessorsData[tpid].getRequests[pid].InitRequest();
+        getRequest.destination = dst;
+        getRequest.globalId = globalId;
+        getRequest.offset = offset;
+        getRequest.size = (uint32_t)nbytes;
+    }
+
+    /**
+     * Gets a buffer of size nbytes from source pointer src that is located in the thread with ID pid at offset from
+     * source pointer src and stores it at the location of dst, without buffering. During the next Sync the requesting
+     * processor copies the data directly from the registered memory of processor pid.
+     *
+     * @param   pid         The processor ID.
+     * @param   src         Source to read the buffer from.
+     * @param   offset      The offset from the source to start reading from.
+     * @param [in,out]  dst Destination to write the buffer to.
+     * @param   nbytes      The size of the message to be written in bytes.
+     *
+     * @pre
+     * * Begin has been called.
+     * * src != nullptr.
+     * * dst != nullptr.
+     * * Push has been called on src with at least size offset + nbytes in the processor with ID pid.
+     * * A Sync has happened between PushReg and this call.
+     *
+     * @post The data is read before any put of the same superstep is applied.
+     */
+
+    inline void HPGet(uint32_t pid, const void *src, ptrdiff_t offset, void *dst, size_t nbytes)
     {
         uint32_t &tpid = ProcId();
 
@@ -729,19 +1174,16 @@ public:
         assert(tpid < mProcCount);
         assert(pid < mProcCount);
         assert(src && dst);
+        assert(!mProcessorsData[tpid].syncPending);
 #endif
 
-        const uint32_t globalId = mProcessorsData[tpid].threadRegisters.LocalToGlobal(
-                                      src);  //mRegisters[tpid][src].registerCount;
+        const uint32_t globalId = mProcessorsData[tpid].threadRegisters.LocalToGlobal(src);
 
 #ifndef BSP_SKIP_CHECKS
         assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
-        //assert( mProcessorsData[pid].registers[GlobalToLocal( pid, globalId )].size >= offset + nbytes );
 #endif
 
-        //const char *srcBuff = reinterpret_cast<const char *>( GlobalToLocal( pid, globalId ) );
-
-        BSPInternal::GetRequest &getRequest = mProcessorsData[tpid].getRequests[pid].InitRequest();
+        BSPInternal::GetRequest &getRequest = mProcessorsData[tpid].hpGetRequests[pid].InitRequest();
         getRequest.destination = dst;
         getRequest.globalId = globalId;
         getRequest.offset = offset;
@@ -761,29 +1203,54 @@ public:
      * * Tagsize is equal on all threads.
      */
 
-    inline void Send(uint32_t pid, const void *tag, const void *payload, const size_t size)
+    BSP_FORCEINLINE void Send(uint32_t pid, const void *tag, const void *payload, const size_t size)
     {
         uint32_t &tpid = ProcId();
 
 #ifndef BSP_SKIP_CHECKS
         assert(pid < mProcCount);
         assert(tpid < mProcCount);
+        assert(!mProcessorsData[tpid].syncPending);
 #endif // !BSP_SKIP_CHECKS
         assert(mProcessorsData[tpid].newTagSize == mTagSize);
 
-        const char *srcBuff = reinterpret_cast<const char *>(payload);
-        const char *tagBuff = reinterpret_cast<const char *>(tag);
+        ProcessorData &data = mProcessorsData[tpid];
+        BSPInternal::StackAllocator::StackLocation bufferLocation =
+            data.tmpSendBufferStacks[data.sendSet][pid].Alloc(size, reinterpret_cast<const char *>(payload));
+
+        FinishSend(data, pid, tag, bufferLocation, size);
+    }
 
-        BSPInternal::StackAllocator &tmpSendBuffer = mProcessorsData[tpid].tmpSendBufferStacks[pid];
+    /**
+     * Sends a message with a payload of a size known at compile time, so the payload is buffered with moves of its
+     * fixed size. The payload is not stored in the send request, since the received messages are indexed by request.
+     *
+     * @tparam  tSize The size of the payload in bytes.
+     *
+     * @param   pid     The processor ID to send the message to.
+     * @param   tag     The tag to identify the message with.
+     * @param   payload The payload of the message.
+     *
+     * @pre See Send.
+     */
 
-        BSPInternal::StackAllocator::StackLocation bufferLocation = tmpSendBuffer.Alloc(size, srcBuff);
-        BSPInternal::StackAllocator::StackLocation tagLocation = tmpSendBuffer.Alloc(mTagSize, tagBuff);
+    template< size_t tSize >
+    BSP_FORCEINLINE void SendFixed(uint32_t pid, const void *tag, const void *payload)
+    {
+        uint32_t &tpid = ProcId();
 
-        BSPInternal::SendRequest &sendRequest = mProcessorsData[tpid].tmpSendRequests[pid].InitRequest();
-        sendRequest.bufferLocation = bufferLocation;
-        sendRequest.bufferSize = (uint32_t)size;
-        sendRequest.tagLocation = tagLocation;
-        sendRequest.tagSize = mTagSize;
+#ifndef BSP_SKIP_CHECKS
+        assert(pid < mProcCount);
+        assert(tpid < mProcCount);
+        assert(!mProcessorsData[tpid].syncPending);
+#endif // !BSP_SKIP_CHECKS
+        assert(mProcessorsData[tpid].newTagSize == mTagSize);
+
+        ProcessorData &data = mProcessorsData[tpid];
+        BSPInternal::StackAllocator::StackLocation bufferLocation =
+            data.tmpSendBufferStacks[data.sendSet][pid].AllocFixed< tSize >(reinterpret_cast<const char *>(payload));
+
+        FinishSend(data, pid, tag, bufferLocation, tSize);
     }
 
     /**
@@ -808,17 +1275,140 @@ public:
         uint32_t &pid = ProcId();
         ProcessorData &data = mProcessorsData[pid];
 
-        if (data.sendRequests.Empty() || data.sendReceivedIndex >= data.sendRequests.GetSize())
+#ifndef BSP_SKIP_CHECKS
+        // The messages may be delivered by another processor during a split phase sync
+        assert(!data.syncPending);
+#endif
+
+        if (data.sendReceivedIndex >= data.sendRequestsSize)
         {
             return;
         }
 
         assert(payload);
 
-        BSPInternal::SendRequest &request = data.sendRequests[data.sendReceivedIndex++];
+        const BSPInternal::StackAllocator *buffer;
+        const BSPInternal::SendRequest &request = FindSendRequest(data, data.sendReceivedIndex++, buffer);
 
         const size_t copySize = std::min((uint32_t)max_copy_size_in, request.bufferSize);
-        data.sendBufferStack.Extract(request.bufferLocation, copySize, (char *)payload);
+        buffer->Extract(request.bufferLocation, copySize, (char *)payload);
+    }
+
+    /**
+     * Moves the first message in the queue without copying it, by returning pointers to the tag and payload in the
+     * receive buffers.
+     *
+     * @param [in,out]  tag     The output destination for the pointer to the tag.
+     * @param [in,out]  payload The output destination for the pointer to the payload.
+     *
+     * @return The size of the payload in bytes, or -1 when the queue is empty or the cursor is at/behind the end.
+     *
+     * @pre
+     * * Begin has been called.
+     * * tag != nullptr.
+     * * payload != nullptr.
+     *
+     * @post
+     * * The pointers stay valid until the next Sync.
+     * * The queue cursor for the send queue is moved to the next message.
+     */
+
+    inline size_t HPMove(const void **tag, const void **payload)
+    {
+        assert(tag && payload);
+
+        BSPInternal::MessageView message;
+
+        if (!HPMove(message))
+        {
+            return (size_t) - 1;
+        }
+
+        *tag = message.tag;
+        *payload = message.payload;
+
+        return message.size;
+    }
+
+    /**
+     * Moves the first message in the queue without copying it, by returning a view on the message.
+     *
+     * @param [in,out]  message The output destination for the view on the message.
+     *
+     * @return true if a message was moved, false if the queue is empty or the cursor is at/behind the end.
+     *
+     * @pre Begin has been called.
+     *
+     * @post
+     * * The view stays valid until the next Sync.
+     * * If a message was moved, the queue cursor for the send queue is moved to the next message.
+     */
+
+    inline bool HPMove(BSPInternal::MessageView &message)
+    {
+        uint32_t &pid = ProcId();
+        ProcessorData &data = mProcessorsData[pid];
+
+#ifndef BSP_SKIP_CHECKS
+        assert(!data.syncPending);
+#endif
+
+        if (data.sendReceivedIndex >= data.sendRequestsSize)
+        {
+            return false;
+        }
+
+        message = PeekMessage(data.sendReceivedIndex++);
+
+        return true;
+    }
+
+    /**
+     * Gets a view on a message in the receive queue, without copying it and without moving the queue cursor.
+     *
+     * @param   index The index of the message in the receive queue.
+     *
+     * @return The message view, which stays valid until the next Sync.
+     *
+     * @pre
+     * * Begin has been called.
+     * * index < GetMessageCount().
+     */
+
+    inline BSPInternal::MessageView PeekMessage(size_t index)
+    {
+        const BSPInternal::StackAllocator *buffer;
+        const BSPInternal::SendRequest &request = FindSendRequest(mProcessorsData[ProcId()], index, buffer);
+
+        BSPInternal::MessageView message;
+        message.tag = buffer->Data(request.bufferLocation + request.bufferSize);
+        message.payload = buffer->Data(request.bufferLocation);
+        message.tagSize = mTagSize;
+        message.size = request.bufferSize;
+
+        return message;
+    }
+
+    /**
+     * Gets the number of messages in the receive queue, including the messages that have already been moved.
+     *
+     * @return The message count.
+     */
+
+    inline size_t GetMessageCount()
+    {
+        return mProcessorsData[ProcId()].sendRequestsSize;
+    }
+
+    /**
+     * Gets the position of the receive queue cursor, which is the index of the next message to be moved.
+     *
+     * @return The message cursor.
+     */
+
+    inline size_t GetMessageCursor()
+    {
+        return std::min<size_t>(mProcessorsData[ProcId()].sendReceivedIndex, GetMessageCount());
     }
 
     /**
@@ -863,21 +1453,15 @@ public:
         *status = (size_t) - 1;
         ProcessorData &data = mProcessorsData[pid];
 
-        size_t index = data.sendReceivedIndex;
-        const BSPInternal::RequestVector< BSPInternal::SendRequest > &sendQueue = data.sendRequests;
-
-        if (!sendQueue.Empty() && index < sendQueue.GetSize())
+        if (data.sendReceivedIndex < data.sendRequestsSize)
         {
-            const BSPInternal::SendRequest &sendRequest = sendQueue[index];
+            const BSPInternal::StackAllocator *buffer;
+            const BSPInternal::SendRequest &sendRequest = FindSendRequest(data, data.sendReceivedIndex, buffer);
             *status = sendRequest.bufferSize;
 
             char *tagBuff = reinterpret_cast<char *>(tag);
 
-#ifndef BSP_SKIP_CHECKS
-            assert(sendQueue[index].tagSize == mTagSize);
-#endif // !BSP_SKIP_CHECKS
-
-            data.sendBufferStack.Extract(sendRequest.tagLocation, sendRequest.tagSize, tagBuff);
+            buffer->Extract(sendRequest.bufferLocation + sendRequest.bufferSize, mTagSize, tagBuff);
         }
     }
 
@@ -909,7 +1493,12 @@ public:
           mProcCount(0),
           mTagSize(0),
           mEnded(true),
-          mAbort(false)
+          mAbort(false),
+#ifdef BSP_PERSISTENT_WORKERS
+          mPersistentWorkers(true)
+#else
+          mPersistentWorkers(false)
+#endif
     {
     }
 
@@ -947,10 +1536,17 @@ private:
 
     tBarrier mThreadBarrier;
 
-    std::vector< ProcessorData > mProcessorsData;
+    /// The barrier of the split phase syncs, where the processors arrive in SyncBegin and wait in SyncEnd
+    BSPInternal::SplitBarrier mSplitBarrier;
+
+    tProcessorsData mProcessorsData;
 
     std::vector< std::future< void >> mThreads;
 
+    BSPInternal::WorkerPool mWorkerPool;
+
+    BSPInternal::ThreadPlacement mPlacement;
+
     tHistoryRecorder mHistoryRecorder;
 
     std::function< void() > mEntry;
@@ -959,6 +1555,7 @@ private:
 
     bool mEnded;
     std::atomic_bool mAbort;
+    bool mPersistentWorkers;
 
     inline void StartTiming()
     {
@@ -972,95 +1569,454 @@ private:
         if (mAbort)
         {
             mThreadBarrier.NotifyAbort();
+            mSplitBarrier.NotifyAbort();
             throw BSPInternal::BspAbort("Aborted");
         }
     }
 
-    inline void CheckSyncBools(uint32_t pid)
-    {
-        CheckHasGetRequests(pid);
-        CheckHasPopRequests(pid);
-        CheckHasPushRequests(pid);
-        CheckHasPutRequests(pid);
-        CheckHasSendRequests(pid);
-        CheckHasTagSizeUpdate(pid);
-    }
+    /**
+     * Delivers the communication of a sync, after all processors have arrived at its first barrier.
+     *
+     * @param   pid       The current processor.
+     * @param   syncFlags The requests all processors had pending, combined in the first barrier.
+     */
 
-    inline bool CollectSyncBools(uint32_t pid)
+    inline void ProcessSync(uint32_t pid, uint32_t syncFlags)
     {
-        auto &syncBools = mProcessorsData[pid].syncBools;
+        ProcessorData &data = mProcessorsData[pid];
+        mHistoryRecorder.RecordProcessorsData(pid, mProcessorsData);
 
-        for (uint32_t owner = 0; owner < mProcCount; ++owner)
+        if (syncFlags & BSPInternal::TagSizeUpdateFlag)
         {
-            syncBools.hasGetRequests |= mProcessorsData[owner].syncBools.hasGetRequests;
-            syncBools.hasPopRequests |= mProcessorsData[owner].syncBools.hasPopRequests;
-            syncBools.hasPushRequests |= mProcessorsData[owner].syncBools.hasPushRequests;
-            syncBools.hasPutRequests |= mProcessorsData[owner].syncBools.hasPutRequests;
-            syncBools.hasSendRequests |= mProcessorsData[owner].syncBools.hasSendRequests;
-            syncBools.hasTagSizeUpdate |= mProcessorsData[owner].syncBools.hasTagSizeUpdate;
+            //printf( "%d updates tagsize\n", pid );
+            ProcessTagSizeUpdate(pid);
         }
 
-        return syncBools.hasGetRequests || syncBools.hasPopRequests || syncBools.hasPushRequests || syncBools.hasPutRequests ||
-               syncBools.hasSendRequests || syncBools.hasTagSizeUpdate;
-    }
-
-    inline void ResetBools(uint32_t pid)
-    {
-        auto &syncBools = mProcessorsData[pid].syncBools;
-        syncBools.hasGetRequests = false;
-        syncBools.hasPopRequests = false;
-        syncBools.hasPushRequests = false;
-        syncBools.hasPutRequests = false;
-        syncBools.hasSendRequests = false;
-        syncBools.hasTagSizeUpdate = false;
-    }
-
-    inline void CheckHasPushRequests(size_t pid)
-    {
-        ProcessorData &data = mProcessorsData[pid];
-        data.syncBools.hasPushRequests = !data.pushRequests.Empty();
-    }
-
-    inline void ProcessPushRequests(size_t pid)
-    {
-        ProcessorData &data = mProcessorsData[pid];
-
-        if (!data.pushRequests.Empty())
+        if (syncFlags & BSPInternal::GetRequestsFlag)
         {
-            for (auto pushRequest = data.pushRequests.Begin(), end = data.pushRequests.End(); pushRequest != end; ++pushRequest)
-            {
-                data.threadRegisters.Insert(pushRequest->pushRegister, pushRequest->registerInfo);
-            }
-
-            data.pushRequests.Clear();
+            //printf( "%d buffers get\n", pid );
+            BufferGetRequests(pid);
         }
-    }
-
-    inline void CheckHasPutRequests(uint32_t pid)
-    {
-        volatile bool &hasPutRequests = mProcessorsData[pid].syncBools.hasPutRequests;
-        hasPutRequests = false;
 
-        for (size_t target = 0; !hasPutRequests && target < mProcCount; ++target)
+        if (syncFlags & BSPInternal::HPGetRequestsFlag)
         {
-            hasPutRequests = !mProcessorsData[pid].putRequests[target].Empty();
+            //printf( "%d processes hpget\n", pid );
+            ProcessHPGetRequests(pid);
         }
-    }
 
-    inline void ProcessPutRequests(uint32_t pid)
-    {
-        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid](uint32_t owner)
+        if ((syncFlags & (BSPInternal::TagSizeUpdateFlag | BSPInternal::GetRequestsFlag)) ||
+            ((syncFlags & BSPInternal::HPGetRequestsFlag) &&
+             (syncFlags & (BSPInternal::PutRequestsFlag | BSPInternal::HPPutRequestsFlag))))
         {
-            BSPInternal::RequestVector< BSPInternal::PutRequest > &putQueue = mProcessorsData[owner].putRequests[pid];
+            //printf( "%d syncs tagsize or get\n", pid );
+            SyncPoint();
+        }
 
-            if (!putQueue.Empty())
+        if (syncFlags & BSPInternal::PopRequestsFlag)
+        {
+            //printf( "%d processes pop\n", pid );
+            ProcessPopRequests(pid);
+        }
+
+        if (syncFlags & BSPInternal::SendRequestsFlag)
+        {
+            //printf( "%d processes send\n", pid );
+            ProcessSendRequests(pid);
+        }
+        else if (data.sendRequestsSize)
+        {
+            ClearReceivedMessages(pid);
+        }
+
+        if (syncFlags & BSPInternal::PutRequestsFlag)
+        {
+            //printf( "%d processes put\n", pid );
+            ProcessPutRequests(pid);
+        }
+
+        if (syncFlags & BSPInternal::HPPutRequestsFlag)
+        {
+            //printf( "%d processes hpput\n", pid );
+            ProcessHPPutRequests(pid);
+        }
+
+        if (syncFlags & BSPInternal::GetRequestsFlag)
+        {
+            //printf( "%d processes get\n", pid );
+            ProcessGetRequests(pid);
+        }
+
+        // Unbuffered puts and gets read the memory of other processors, and pops may not be seen by other processors
+        // before they finished this superstep
+        if ((syncFlags & (BSPInternal::HPPutRequestsFlag | BSPInternal::HPGetRequestsFlag | BSPInternal::PopRequestsFlag)) ||
+            (syncFlags && mHistoryRecorder.RecordsProcessorsData()))
+        {
+            //printf( "%d enters massive sync\n", pid );
+            SyncPoint();
+        }
+
+        if (syncFlags & BSPInternal::PaddedPopRequestsFlag)
+        {
+            //printf( "%d processes padded pop\n", pid );
+            ProcessPaddedPopRequests(pid);
+            SyncPoint();
+        }
+
+        if (syncFlags & BSPInternal::PopRequestsFlag)
+        {
+            //printf( "%d clears pop\n", pid );
+            ClearPopRequests(pid);
+        }
+
+        if (syncFlags & BSPInternal::SendRequestsFlag)
+        {
+            //printf( "%d clears send\n", pid );
+            ClearSendRequests(pid);
+        }
+
+        if (syncFlags & BSPInternal::PutRequestsFlag)
+        {
+            //printf( "%d clears put\n", pid );
+            ClearPutBuffer(pid);
+        }
+
+        if (syncFlags & BSPInternal::PushRequestsFlag)
+        {
+            //printf( "%d processes push\n", pid );
+            ProcessPushRequests(pid);
+            SyncPoint();
+        }
+
+        mHistoryRecorder.RecordPostSync(pid);
+    }
+
+    /**
+     * Delivers the puts and sends of a split phase sync to the given processor, which may still be doing the local
+     * work of its split phase. This only writes the registers and the receive queue of the target, which it does not
+     * use until its SyncEnd, and reads the buffers of the owners, which they do not clear before the next sync.
+     *
+     * @param   target    The processor to deliver to.
+     * @param   syncFlags The requests all processors had pending, combined in the split barrier.
+     */
+
+    inline void DeliverSplitSync(uint32_t target, uint32_t syncFlags)
+    {
+        if (syncFlags & BSPInternal::SendRequestsFlag)
+        {
+            ProcessSendRequests(target);
+        }
+
+        if (syncFlags & BSPInternal::PutRequestsFlag)
+        {
+            ProcessPutRequests(target);
+        }
+    }
+
+    inline uint32_t CollectSyncFlags(uint32_t pid)
+    {
+        uint32_t flags = 0;
+
+        if (HasGetRequests(pid))
+        {
+            flags |= BSPInternal::GetRequestsFlag;
+        }
+
+        if (HasHPGetRequests(pid))
+        {
+            flags |= BSPInternal::HPGetRequestsFlag;
+        }
+
+        if (HasPopRequests(pid))
+        {
+            flags |= BSPInternal::PopRequestsFlag;
+
+            if (HasPaddedPopRequests(pid))
             {
-                for (auto putRequest = putQueue.RBegin(), end = putQueue.REnd(); putRequest != end; ++putRequest)
+                flags |= BSPInternal::PaddedPopRequestsFlag;
+            }
+        }
+
+        if (HasPushRequests(pid))
+        {
+            flags |= BSPInternal::PushRequestsFlag;
+        }
+
+        if (HasPutRequests(pid))
+        {
+            flags |= BSPInternal::PutRequestsFlag;
+        }
+
+        if (HasHPPutRequests(pid))
+        {
+            flags |= BSPInternal::HPPutRequestsFlag;
+        }
+
+        if (HasSendRequests(pid))
+        {
+            flags |= BSPInternal::SendRequestsFlag;
+        }
+
+        if (HasTagSizeUpdate(pid))
+        {
+            flags |= BSPInternal::TagSizeUpdateFlag;
+        }
+
+        return flags;
+    }
+
+    inline bool HasPushRequests(size_t pid) const
+    {
+        return !mProcessorsData[pid].pushRequests.Empty();
+    }
+
+    inline void ProcessPushRequests(size_t pid)
+    {
+        ProcessorData &data = mProcessorsData[pid];
+
+        if (!data.pushRequests.Empty())
+        {
+            for (auto pushRequest = data.pushRequests.Begin(), end = data.pushRequests.End(); pushRequest != end; ++pushRequest)
+            {
+                data.threadRegisters.Insert(pushRequest->pushRegister, pushRequest->registerInfo);
+            }
+
+            data.pushRequests.Clear();
+        }
+    }
+
+    /**
+     * Finishes a send of which the payload has been buffered, by buffering the tag after it and recording the
+     * message.
+     *
+     * @param [in,out]  data    The data of the sending processor.
+     * @param   pid             The processor ID to send the message to.
+     * @param   tag             The tag to identify the message with.
+     * @param   bufferLocation  The location of the payload in the send buffer.
+     * @param   size            The size of the payload in bytes.
+     */
+
+    BSP_FORCEINLINE void FinishSend(ProcessorData &data, uint32_t pid, const void *tag,
+                                    BSPInternal::StackAllocator::StackLocation bufferLocation, size_t size)
+    {
+        BSPInternal::StackAllocator &tmpSendBuffer = data.tmpSendBufferStacks[data.sendSet][pid];
+
+#ifndef BSP_SKIP_CHECKS
+        assert(tag || mTagSize == 0);
+#endif
+
+        // Messages without a tag may pass no tag at all
+        if (tag)
+        {
+            tmpSendBuffer.Alloc(mTagSize, reinterpret_cast<const char *>(tag));
+        }
+
+#ifndef BSP_SKIP_CHECKS
+        assert(tmpSendBuffer.Size() <= std::numeric_limits< uint32_t >::max());
+#endif
+
+        BSPInternal::SendRequest &sendRequest = data.tmpSendRequests[data.sendSet][pid].InitRequest();
+        sendRequest.bufferLocation = (uint32_t)bufferLocation;
+        sendRequest.bufferSize = (uint32_t)size;
+    }
+
+    /**
+     * Merges a put into the previous put in the queue, when it continues that put to the same register, both in
+     * the register and in the put buffer, so element wise puts are copied as a single block during the sync. A
+     * previous inline put is moved to the put buffer to be merged.
+     *
+     * @return true if the put has been merged.
+     */
+
+    BSP_FORCEINLINE bool MergePut(BSPInternal::PutRequestVector &putQueue, BSPInternal::StackAllocator &putBuffer,
+                                  const char *srcBuff, uint32_t globalId, ptrdiff_t offset, size_t nbytes)
+    {
+        if (putQueue.Empty())
+        {
+            return false;
+        }
+
+        const size_t lastIndex = putQueue.LastPut();
+        BSPInternal::PutRequest &last = putQueue[lastIndex];
+
+        if (last.GlobalId() != globalId || static_cast<ptrdiff_t>(last.offset) + last.Size() != offset ||
+                nbytes > std::numeric_limits< uint32_t >::max() - last.Size())
+        {
+            return false;
+        }
+
+        if (last.IsInline())
+        {
+            const uint64_t bufferLocation = static_cast<uint64_t>(putBuffer.Size());
+            const uint32_t records = BSPInternal::PutRequest::BufferedRecords(bufferLocation);
+
+            // The buffered put has to fit in the records of the inline put
+            if (records > last.Records())
+            {
+                return false;
+            }
+
+            const uint32_t inlineSize = last.Size();
+            putBuffer.Alloc(inlineSize, putQueue.Payload(lastIndex));
+            putQueue.TruncateLastPut(records);
+            putQueue.SetBuffered(lastIndex, globalId, bufferLocation, inlineSize);
+        }
+        else if (putQueue.BufferLocation(lastIndex) + last.size != static_cast<uint64_t>(putBuffer.Size()))
+        {
+            return false;
+        }
+
+        putBuffer.Alloc(nbytes, srcBuff);
+        last.size += (uint32_t)nbytes;
+
+        return true;
+    }
+
+    template< size_t tSize >
+    BSP_FORCEINLINE void PutFixed(uint32_t pid, const void *src, uint32_t globalId, ptrdiff_t offset, std::true_type)
+    {
+        uint32_t &tpid = ProcId();
+        mHistoryRecorder.InitCommunication(tpid);
+
+#ifndef BSP_SKIP_CHECKS
+        assert(tpid < mProcCount);
+        assert(pid < mProcCount);
+        assert(src);
+        assert(mProcessorsData[pid].threadRegisters.GetSize() > globalId);
+        assert(!mProcessorsData[tpid].syncPending);
+        assert(offset >= 0 && offset <= std::numeric_limits< uint32_t >::max());
+#endif
+
+        const char *srcBuff = reinterpret_cast<const char *>(src);
+
+        ProcessorData &data = mProcessorsData[tpid];
+        BSPInternal::PutRequestVector &putQueue = data.putRequests[data.putSet][pid];
+
+        if (!MergePut(putQueue, data.putBufferStacks[data.putSet], srcBuff, globalId, offset, tSize))
+        {
+            putQueue.InitInline< tSize >(globalId, (uint32_t)offset, srcBuff);
+        }
+
+        mHistoryRecorder.FinishCommunication(tpid);
+    }
+
+    template< size_t tSize >
+    BSP_FORCEINLINE void PutFixed(uint32_t pid, const void *src, uint32_t globalId, ptrdiff_t offset, std::false_type)
+    {
+        PutRegister(pid, src, globalId, offset, tSize);
+    }
+
+    inline bool HasPutRequests(uint32_t pid) const
+    {
+        const ProcessorData &data = mProcessorsData[pid];
+
+        for (size_t target = 0; target < mProcCount; ++target)
+        {
+            if (!data.putRequests[data.putSet][target].Empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline void ProcessPutRequests(uint32_t pid)
+    {
+        // The owners may already have moved on to their next put set, so we use our own
+        const uint32_t putSet = mProcessorsData[pid].putSet;
+
+        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid, putSet](uint32_t owner)
+        {
+            BSPInternal::PutRequestVector &putQueue = mProcessorsData[owner].putRequests[putSet][pid];
+
+            if (!putQueue.Empty())
+            {
+                const BSPInternal::StackAllocator &putBuffer = mProcessorsData[owner].putBufferStacks[putSet];
+                uint32_t globalId = putQueue[0].GlobalId();
+                char *registerBuff = static_cast<char *>(const_cast<void *>(mProcessorsData[pid].threadRegisters.GlobalToLocal(
+                                                                                globalId)));
+
+                // Applied in the order they were issued, so the last put to a location wins
+                for (size_t index = 0, size = putQueue.GetSize(); index < size; index += putQueue[index].Records())
+                {
+                    const BSPInternal::PutRequest &putRequest = putQueue[index];
+
+                    // Consecutive puts usually target the same register, so we only look it up when it changes
+                    if (putRequest.GlobalId() != globalId)
+                    {
+                        globalId = putRequest.GlobalId();
+                        registerBuff = static_cast<char *>(const_cast<void *>(mProcessorsData[pid].threadRegisters.GlobalToLocal(
+                                                                                  globalId)));
+                    }
+
+                    if (putRequest.IsInline())
+                    {
+                        putQueue.CopyInline(index, registerBuff + putRequest.offset);
+                    }
+                    else
+                    {
+                        putBuffer.Extract(static_cast<BSPInternal::StackAllocator::StackLocation>(putQueue.BufferLocation(index)),
+                                          putRequest.size, registerBuff + putRequest.offset);
+                    }
+                }
+
+                putQueue.Clear();
+            }
+        });
+    }
+
+    /**
+     * Switches the given processor to its other put buffer. The put queues are emptied by the targets when they are
+     * processed, and the other buffer was last read in the previous put superstep, by targets that have all passed
+     * the first barrier of this sync since. So the buffer can be reused without waiting for the targets to finish
+     * reading the current one.
+     *
+     * @param   pid The processor ID.
+     */
+
+    inline void ClearPutBuffer(uint32_t pid)
+    {
+        ProcessorData &data = mProcessorsData[pid];
+        data.putSet ^= 1;
+        data.putBufferStacks[data.putSet].Clear();
+
+        if (data.putsReservePending)
+        {
+            data.ReservePuts();
+            data.putsReservePending = false;
+        }
+    }
+
+    inline bool HasHPPutRequests(uint32_t pid) const
+    {
+        const ProcessorData &data = mProcessorsData[pid];
+
+        for (size_t target = 0; target < mProcCount; ++target)
+        {
+            if (!data.hpPutRequests[target].Empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline void ProcessHPPutRequests(uint32_t pid)
+    {
+        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid](uint32_t owner)
+        {
+            BSPInternal::RequestVector< BSPInternal::HPPutRequest > &putQueue = mProcessorsData[owner].hpPutRequests[pid];
+
+            if (!putQueue.Empty())
+            {
+                // Applied in the order they were issued, so the last put to a location wins
+                for (auto putRequest = putQueue.Begin(), end = putQueue.End(); putRequest != end; ++putRequest)
                 {
                     char *dstBuff = static_cast<char *>(const_cast<void *>(mProcessorsData[pid].threadRegisters.GlobalToLocal(
                                                                                putRequest->globalId))) + putRequest->offset;
 
-                    mProcessorsData[owner].putBufferStack.Extract(putRequest->bufferLocation, putRequest->size, dstBuff);
+                    memcpy(dstBuff, putRequest->source, putRequest->size);
                 }
 
                 putQueue.Clear();
@@ -1068,15 +2024,19 @@ private:
         });
     }
 
-    inline void CheckHasGetRequests(uint32_t pid)
+    inline bool HasGetRequests(uint32_t pid) const
     {
-        volatile bool &hasGetRequests = mProcessorsData[pid].syncBools.hasGetRequests;
-        hasGetRequests = false;
+        const ProcessorData &data = mProcessorsData[pid];
 
-        for (size_t target = 0; !hasGetRequests && target < mProcCount; ++target)
+        for (size_t target = 0; target < mProcCount; ++target)
         {
-            hasGetRequests = !mProcessorsData[pid].getRequests[target].Empty();
+            if (!data.getRequests[target].Empty())
+            {
+                return true;
+            }
         }
+
+        return false;
     }
 
     inline void BufferGetRequests(uint32_t pid)
@@ -1088,7 +2048,8 @@ private:
         {
             BSPInternal::RequestVector< BSPInternal::GetRequest > &getQueue = mProcessorsData[owner].getRequests[pid];
 
-            for (auto request = getQueue.RBegin(), end = getQueue.REnd(); request != end; ++request)
+            // Buffered in the order they were issued, so they are also delivered in that order
+            for (auto request = getQueue.Begin(), end = getQueue.End(); request != end; ++request)
             {
                 //const char *srcBuff = reinterpret_cast<const char *>( request->source );
                 const char *srcBuff = reinterpret_cast<const char *>(mProcessorsData[pid].threadRegisters.GlobalToLocal(
@@ -1115,7 +2076,8 @@ private:
 
             if (!getQueue.Empty())
             {
-                for (auto getRequest = getQueue.RBegin(), end = getQueue.REnd(); getRequest != end; ++getRequest)
+                // Delivered in the order they were issued, so the last get into a location wins
+                for (auto getRequest = getQueue.Begin(), end = getQueue.End(); getRequest != end; ++getRequest)
                 {
                     char *dstBuff = static_cast< char * >(const_cast< void * >(getRequest->destination));
 
@@ -1127,81 +2089,290 @@ private:
         });
     }
 
-    inline void CheckHasSendRequests(uint32_t pid)
+    inline bool HasHPGetRequests(uint32_t pid) const
     {
-        volatile bool &hasSendRequests = mProcessorsData[pid].syncBools.hasSendRequests;
-        hasSendRequests = false;
+        const ProcessorData &data = mProcessorsData[pid];
 
-        for (size_t target = 0; !hasSendRequests && target < mProcCount; ++target)
+        for (size_t target = 0; target < mProcCount; ++target)
         {
-            hasSendRequests = !mProcessorsData[pid].tmpSendBufferStacks[target].Empty();
+            if (!data.hpGetRequests[target].Empty())
+            {
+                return true;
+            }
         }
+
+        return false;
+    }
+
+    inline void ProcessHPGetRequests(uint32_t pid)
+    {
+        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid](uint32_t owner)
+        {
+            BSPInternal::RequestVector< BSPInternal::GetRequest > &getQueue = mProcessorsData[pid].hpGetRequests[owner];
+
+            if (!getQueue.Empty())
+            {
+                const tRegisterMap &ownerRegisters = mProcessorsData[owner].threadRegisters;
+
+                // Applied in the order they were issued, so the last get into a location wins
+                for (auto request = getQueue.Begin(), end = getQueue.End(); request != end; ++request)
+                {
+                    const char *srcBuff = reinterpret_cast<const char *>(ownerRegisters.LookupGlobal(request->globalId)) +
+                                          request->offset;
+
+                    memcpy(const_cast<void *>(request->destination), srcBuff, request->size);
+                }
+
+                getQueue.Clear();
+            }
+        });
     }
 
+    inline bool HasSendRequests(uint32_t pid) const
+    {
+        const ProcessorData &data = mProcessorsData[pid];
+
+        for (size_t target = 0; target < mProcCount; ++target)
+        {
+            if (!data.tmpSendRequests[data.sendSet][target].Empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
 
+    /**
+     * Builds the receive queue of the given processor. The messages are not copied, instead a segment is recorded
+     * for every sender, so the messages can be read in place from the send queues of the sender. The senders
+     * switch to their other send queue after this sync, so these stay untouched during the next superstep.
+     *
+     * @param   pid The processor ID.
+     */
 
     inline void ProcessSendRequests(uint32_t pid)
     {
         ProcessorData &data = mProcessorsData[pid];
+        const uint32_t sendSet = data.sendSet;
+        size_t count = 0;
 
-        BSPInternal::StackAllocator::StackLocation offset = 0;
-        BSPInternal::StackAllocator &sendBuffer = data.sendBufferStack;
-        BSPInternal::RequestVector< BSPInternal::SendRequest > &sendQueue = data.sendRequests;
-        sendQueue.Clear();
-        sendBuffer.Clear();
-        data.sendReceivedIndex = 0;
+        ClearReceivedMessages(pid);
 
-        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid, &sendBuffer, &sendQueue, &data, &offset](uint32_t owner)
+        BSPUtil::SplitFor(0u, mProcCount, pid, [this, pid, sendSet, &data, &count](uint32_t owner)
         {
-            BSPInternal::RequestVector< BSPInternal::SendRequest > &tmpQueue = mProcessorsData[owner].tmpSendRequests[pid];
-            BSPInternal::StackAllocator &tmpBuffer = mProcessorsData[owner].tmpSendBufferStacks[pid];
+            const BSPInternal::RequestVector< BSPInternal::SendRequest > &tmpQueue =
+                mProcessorsData[owner].tmpSendRequests[sendSet][pid];
 
-            for (auto request = tmpQueue.Begin(), end = tmpQueue.End(); request != end; ++request)
+            if (!tmpQueue.Empty())
             {
-                request->bufferLocation += offset;
-                request->tagLocation += offset;
-            }
+                count += tmpQueue.GetSize();
 
-            offset += tmpBuffer.Size();
-            sendBuffer.Merge(tmpBuffer);
-            sendQueue.Append(tmpQueue.Begin(), tmpQueue.End());
+                BSPInternal::SendSegment segment;
+                segment.requests = &tmpQueue;
+                segment.buffer = &mProcessorsData[owner].tmpSendBufferStacks[sendSet][pid];
+                segment.end = count;
+                data.sendSegments.push_back(segment);
+            }
         });
+
+        data.sendRequestsSize = (uint32_t)count;
+    }
+
+    inline void ClearReceivedMessages(uint32_t pid)
+    {
+        ProcessorData &data = mProcessorsData[pid];
+        data.sendSegments.clear();
+        data.sendRequestsSize = 0;
+        data.sendReceivedIndex = 0;
+        data.sendSegmentIndex = 0;
     }
 
+    /**
+     * Switches the given processor to its other send queue. The receivers stop reading it when they process the
+     * sends of the next sync, which they all did before the first barrier of this sync was passed.
+     *
+     * @param   pid The processor ID.
+     */
+
     inline void ClearSendRequests(uint32_t pid)
     {
+        ProcessorData &data = mProcessorsData[pid];
+        data.sendSet ^= 1;
+
         for (uint32_t target = 0; target < mProcCount; ++target)
         {
-            mProcessorsData[pid].tmpSendBufferStacks[target].Clear();
-            mProcessorsData[pid].tmpSendRequests[target].Clear();
+            data.tmpSendBufferStacks[data.sendSet][target].Clear();
+            data.tmpSendRequests[data.sendSet][target].Clear();
+        }
+
+        if (data.sendsReservePending)
+        {
+            data.ReserveSends();
+            data.sendsReservePending = false;
         }
     }
 
-    inline void CheckHasPopRequests(size_t pid)
+    /**
+     * Finds a message in the receive queue of a processor.
+     *
+     * @param [in,out]  data    The processor data of the receiving processor.
+     * @param           index   The index of the message in the receive queue.
+     * @param [out]     buffer  The buffer that holds the tag and payload of the message.
+     *
+     * @return The send request of the message.
+     *
+     * @pre index < data.sendRequestsSize.
+     */
+
+    inline const BSPInternal::SendRequest &FindSendRequest(ProcessorData &data, size_t index,
+                                                           const BSPInternal::StackAllocator *&buffer)
     {
-        ProcessorData &data = mProcessorsData[pid];
-        data.syncBools.hasPopRequests = !data.popRequests.Empty();
+        const std::vector< BSPInternal::SendSegment > &segments = data.sendSegments;
+        uint32_t segment = data.sendSegmentIndex;
+
+        if (index >= segments[segment].end || (segment > 0 && index < segments[segment - 1].end))
+        {
+            segment = (uint32_t)(std::upper_bound(segments.begin(), segments.end(), index,
+                                                  [](size_t i, const BSPInternal::SendSegment & s)
+            {
+                return i < s.end;
+            }) - segments.begin());
+            data.sendSegmentIndex = segment;
+        }
+
+        const size_t begin = segment > 0 ? segments[segment - 1].end : 0;
+        buffer = segments[segment].buffer;
+
+        return (*segments[segment].requests)[index - begin];
+    }
+
+    inline bool HasPopRequests(size_t pid) const
+    {
+        return !mProcessorsData[pid].popRequests.Empty();
+    }
+
+    inline bool HasPaddedPopRequests(size_t pid) const
+    {
+        const ProcessorData &data = mProcessorsData[pid];
+
+        for (auto popRequest = data.popRequests.CBegin(), end = data.popRequests.CEnd(); popRequest != end; ++popRequest)
+        {
+            if (!popRequest->popRegister)
+            {
+                return true;
+            }
+        }
+
+        return false;
     }
 
+    /**
+     * Pops the registers the given processor popped, except for its padding, which is popped once all processors
+     * resolved their pops.
+     *
+     * @param   pid The processor ID.
+     */
+
     inline void ProcessPopRequests(size_t pid)
     {
         ProcessorData &data = mProcessorsData[pid];
 
-        if (!data.popRequests.Empty())
+        for (auto popRequest = data.popRequests.Begin(), end = data.popRequests.End(); popRequest != end; ++popRequest)
         {
-            for (auto popRequest = data.popRequests.Begin(), end = data.popRequests.End(); popRequest != end; ++popRequest)
+            if (popRequest->popRegister)
             {
-                data.threadRegisters.Erase(popRequest->popRegister);
+                popRequest->globalId = data.threadRegisters.Erase(popRequest->popRegister);
             }
+        }
+    }
 
-            data.popRequests.Clear();
+    /**
+     * Pops the padding the given processor popped. Padding cannot be told apart, so every pop of padding takes the
+     * registration the first processor that popped a register at the same position resolved. When all processors
+     * popped padding, the most recent padding is popped.
+     *
+     * @param   pid The processor ID.
+     *
+     * @pre All processors have processed their pop requests.
+     */
+
+    inline void ProcessPaddedPopRequests(size_t pid)
+    {
+        ProcessorData &data = mProcessorsData[pid];
+
+        for (size_t index = 0, size = data.popRequests.GetSize(); index < size; ++index)
+        {
+            BSPInternal::PopRequest &popRequest = data.popRequests[index];
+
+            if (popRequest.popRegister)
+            {
+                continue;
+            }
+
+            popRequest.globalId = (uint32_t)(-1);
+
+            for (uint32_t owner = 0; owner < mProcCount; ++owner)
+            {
+                const BSPInternal::RequestVector< BSPInternal::PopRequest > &popRequests = mProcessorsData[owner].popRequests;
+
+#ifndef BSP_SKIP_CHECKS
+                // Every processor pops the same registers
+                assert(popRequests.GetSize() == size);
+#endif
+
+                if (popRequests[index].popRegister)
+                {
+                    popRequest.globalId = data.threadRegisters.Erase(nullptr, popRequests[index].globalId);
+                    break;
+                }
+            }
+
+            if (popRequest.globalId == (uint32_t)(-1))
+            {
+                popRequest.globalId = data.threadRegisters.Erase(nullptr);
+            }
         }
     }
 
-    inline void CheckHasTagSizeUpdate(size_t pid)
+    /**
+     * Frees the global IDs of the registers the given processor popped, so they can be reused by the pushes of the
+     * next superstep, since requests to the popped registers may only be made in this superstep.
+     *
+     * @param   pid The processor ID.
+     *
+     * @pre All processors have popped their registers, and no processor reads the pop requests anymore.
+     */
+
+    inline void ClearPopRequests(size_t pid)
     {
         ProcessorData &data = mProcessorsData[pid];
-        data.syncBools.hasTagSizeUpdate = data.newTagSize != mTagSize;
+
+        if (data.popRequests.Empty())
+        {
+            return;
+        }
+
+        const size_t freedBegin = data.freeRegisters.size();
+
+        for (auto popRequest = data.popRequests.CBegin(), end = data.popRequests.CEnd(); popRequest != end; ++popRequest)
+        {
+            if (popRequest->globalId != (uint32_t)(-1))
+            {
+                data.freeRegisters.push_back(popRequest->globalId);
+            }
+        }
+
+        // All processors free the same IDs, but resolve the pops of padding later, so we order the IDs to keep the
+        // free lists equal on all processors
+        std::sort(data.freeRegisters.begin() + freedBegin, data.freeRegisters.end());
+
+        data.popRequests.Clear();
+    }
+
+    inline bool HasTagSizeUpdate(size_t pid) const
+    {
+        return mProcessorsData[pid].newTagSize != mTagSize;
     }
 
     inline void ProcessTagSizeUpdate(size_t pid)
@@ -27,8 +27,10 @@
 #ifndef __BSPLIB_BSPEXT_H__
 #define __BSPLIB_BSPEXT_H__
 
+#include "bsp/messageRange.h"
 #include "bsp/bspClass.h"
 #include "bsp/bspProf.h"
+#include "bsp/register.h"
 #include "bsp/util.h"
 
 #include <cstdint>
@@ -140,21 +142,17 @@ namespace BSPLib
 
         BSP_FORCEINLINE size_t HPMove(void **tagPtr, void **payloadPtr)
         {
-            BSP &bsp = BSP::GetInstance();
-            size_t status;
-            bsp.GetTag(&status, *tagPtr);
-            bsp.Move(*payloadPtr, status);
-            return status;
+            return BSP::GetInstance().HPMove(const_cast<const void **>(tagPtr), const_cast<const void **>(payloadPtr));
         }
 
         BSP_FORCEINLINE void HPPut(uint32_t pid, const void *src, void *dst, ptrdiff_t offset, size_t nbytes)
         {
-            BSP::GetInstance().Put(pid, src, dst, offset, nbytes);
+            BSP::GetInstance().HPPut(pid, src, dst, offset, nbytes);
         }
 
         BSP_FORCEINLINE void HPGet(uint32_t pid, const void *src, ptrdiff_t offset, void *dst, size_t nbytes)
         {
-            BSP::GetInstance().Get(pid, src, offset, dst, nbytes);
+            BSP::GetInstance().HPGet(pid, src, offset, dst, nbytes);
         }
     }
 
@@ -178,6 +176,16 @@ namespace BSPLib
         BSP::GetInstance().SyncSendRequests();
     }
 
+    BSP_FORCEINLINE void SyncBegin()
+    {
+        BSP::GetInstance().SyncBegin();
+    }
+
+    BSP_FORCEINLINE void SyncEnd()
+    {
+        BSP::GetInstance().SyncEnd();
+    }
+
     BSP_FORCEINLINE void SyncPoint()
     {
         BSP::GetInstance().SyncPoint();
@@ -209,9 +217,12 @@ namespace BSPLib
     }
 
     template< typename tPrimitive >
-    void Push(tPrimitive &ident)
+    using Register = BSPInternal::Register< tPrimitive >;
+
+    template< typename tPrimitive >
+    Register< tPrimitive > Push(tPrimitive &ident)
     {
-        Classic::Push(&ident, sizeof(tPrimitive));
+        return Register< tPrimitive >(&ident, 1, BSP::GetInstance().PushReg(&ident, sizeof(tPrimitive)));
     }
 
     inline void Push(const void *ident, size_t byteSize)
@@ -240,7 +251,6 @@ namespace BSPLib
         Classic::Pop(nullptr);
     }
 
-    template<>
     inline void Push(std::string &string)
     {
         Classic::Push(string.data(), string.size());
@@ -255,7 +265,7 @@ namespace BSPLib
     template< typename tPrimitive >
     void Put(uint32_t pid, tPrimitive &src, tPrimitive &dst)
     {
-        Classic::Put(pid, &src, &dst, 0, sizeof(tPrimitive));
+        BSP::GetInstance().PutFixed< sizeof(tPrimitive) >(pid, &src, &dst);
     }
 
     template <>
@@ -301,15 +311,15 @@ namespace BSPLib
     }
 
     template< typename tPrimitive >
-    void PushPtrs(tPrimitive *begin, size_t count)
+    Register< tPrimitive > PushPtrs(tPrimitive *begin, size_t count)
     {
-        Classic::Push(begin, count * sizeof(tPrimitive));
+        return Register< tPrimitive >(begin, count, BSP::GetInstance().PushReg(begin, count * sizeof(tPrimitive)));
     }
 
     template< typename tPrimitive >
-    void PushPtrs(tPrimitive *begin, tPrimitive *end)
+    Register< tPrimitive > PushPtrs(tPrimitive *begin, tPrimitive *end)
     {
-        PushPtrs(begin, end - begin);
+        return PushPtrs(begin, end - begin);
     }
 
     template< typename tPrimitive >
@@ -318,6 +328,57 @@ namespace BSPLib
         Classic::Pop(begin);
     }
 
+    template< typename tPrimitive >
+    void Pop(const Register< tPrimitive > &reg)
+    {
+        Classic::Pop(reg.Data());
+    }
+
+    // Otherwise Pop(tPrimitive &) would pop the address of the handle itself
+    template< typename tPrimitive >
+    void Pop(Register< tPrimitive > &reg)
+    {
+        Classic::Pop(reg.Data());
+    }
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void PutPtrs(uint32_t pid, const tPrimitive *srcBegin, size_t count, const Register< tPrimitive > &dst,
+                                 size_t offset)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(offset + count <= dst.Size());
+#endif
+
+        BSP::GetInstance().PutRegister(pid, srcBegin, dst.GlobalId(), offset * sizeof(tPrimitive), count * sizeof(tPrimitive));
+    }
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void Put(uint32_t pid, const tPrimitive &src, const Register< tPrimitive > &dst, size_t offset = 0)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(offset < dst.Size());
+#endif
+
+        BSP::GetInstance().PutFixed< sizeof(tPrimitive) >(pid, &src, dst.GlobalId(), offset * sizeof(tPrimitive));
+    }
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void GetPtrs(uint32_t pid, const Register< tPrimitive > &src, size_t offset, tPrimitive *resultBegin,
+                                 size_t count)
+    {
+#ifndef BSP_SKIP_CHECKS
+        assert(offset + count <= src.Size());
+#endif
+
+        BSP::GetInstance().GetRegister(pid, src.GlobalId(), offset * sizeof(tPrimitive), resultBegin, count * sizeof(tPrimitive));
+    }
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void Get(uint32_t pid, const Register< tPrimitive > &src, tPrimitive &dst, size_t offset = 0)
+    {
+        GetPtrs(pid, src, offset, &dst, 1);
+    }
+
     template< typename tPrimitive >
     BSP_FORCEINLINE void PutPtrs(uint32_t pid, tPrimitive *srcBegin, size_t count, tPrimitive *resultBegin, size_t offset)
     {
@@ -395,7 +456,15 @@ namespace BSPLib
     template< typename tPrimitive, typename tTagPrimitive >
     void SendPtrs(uint32_t pid, tTagPrimitive *tag, tPrimitive *begin, size_t count)
     {
-        Classic::Send(pid, tag, begin, count * sizeof(tPrimitive));
+        // A single value, which all the Send overloads end up here with, is copied with moves of its fixed size
+        if (count == 1)
+        {
+            BSP::GetInstance().SendFixed< sizeof(tPrimitive) >(pid, tag, begin);
+        }
+        else
+        {
+            Classic::Send(pid, tag, begin, count * sizeof(tPrimitive));
+        }
     }
 
     template< typename tPrimitive, typename tTagPrimitive >
@@ -470,7 +539,14 @@ namespace BSPLib
     template< typename tPrimitive >
     void SendPtrs(uint32_t pid, tPrimitive *begin, size_t count)
     {
-        Classic::Send(pid, nullptr, begin, count * sizeof(tPrimitive));
+        if (count == 1)
+        {
+            BSP::GetInstance().SendFixed< sizeof(tPrimitive) >(pid, nullptr, begin);
+        }
+        else
+        {
+            Classic::Send(pid, nullptr, begin, count * sizeof(tPrimitive));
+        }
     }
 
     template< typename tPrimitive >
@@ -638,9 +714,9 @@ namespace BSPLib
     }
 
     template< typename tPrimitive, size_t tSize >
-    void PushCArray(tPrimitive(&container)[tSize])
+    Register< tPrimitive > PushCArray(tPrimitive(&container)[tSize])
     {
-        PushPtrs(container, container + tSize);
+        return PushPtrs(container, container + tSize);
     }
 
     template< typename tPrimitive, size_t tSize >
@@ -793,6 +869,31 @@ namespace BSPLib
         Classic::QSize(&packets, &accumulatedSize);
     }
 
+    /**
+     * Moves the first message in the queue without copying it.
+     *
+     * @param [in,out]  message The output destination for the view on the message.
+     *
+     * @return true if a message was moved, false if the queue is empty.
+     */
+
+    inline bool HPMove(BSPInternal::MessageView &message)
+    {
+        return BSP::GetInstance().HPMove(message);
+    }
+
+    /**
+     * Gets a range over the messages in the queue that have not been moved yet. The messages are not copied, and
+     * stay valid until the next Sync.
+     *
+     * @return The message range.
+     */
+
+    inline BSPInternal::MessageRange Messages()
+    {
+        return BSPInternal::MessageRange(BSP::GetInstance());
+    }
+
     template< typename tPrimitive >
     void GetTag(size_t &status, tPrimitive &tag)
     {
@@ -879,6 +980,73 @@ namespace BSPLib
         return Execute(func, nProc, 0, nullptr);
     }
 
+    /**
+     * Sets whether the worker threads are kept alive between BSP programs, so the next Execute only dispatches the
+     * program to the parked workers instead of starting new threads.
+     *
+     * @param   persistent Whether the workers should be persistent.
+     */
+
+    inline void SetPersistentWorkers(bool persistent)
+    {
+        BSP::GetInstance().SetPersistentWorkers(persistent);
+    }
+
+    using Placement = BSPInternal::Placement;
+
+    /**
+     * Sets the policy to place the processors on the CPUs the process may run on, which overrides the `BSP_PLACEMENT`
+     * environment variable.
+     *
+     * @param   placement The placement policy.
+     */
+
+    inline void SetPlacement(Placement placement)
+    {
+        BSP::GetInstance().SetPlacement(placement);
+    }
+
+    /**
+     * Places processor `i` on the CPU at `cpus[i % cpus.size()]`, which overrides the `BSP_PLACEMENT` environment
+     * variable.
+     *
+     * @param   cpus The CPUs to place the processors on.
+     */
+
+    inline void SetPlacement(const std::vector< uint32_t > &cpus)
+    {
+        BSP::GetInstance().SetPlacement(cpus);
+    }
+
+    using BufferPolicy = BSPInternal::BufferPolicy;
+
+    /**
+     * Sets the policy that sizes the buffers of the processors: the expected h-relation in bytes to size them up
+     * front, and when buffers that have been used sparsely for a while release their memory.
+     *
+     * @param   policy The buffer policy.
+     */
+
+    inline void SetBufferPolicy(const BufferPolicy &policy)
+    {
+        BSP::GetInstance().SetBufferPolicy(policy);
+    }
+
+    using CommunicationVolume = BSPInternal::CommunicationVolume;
+
+    /**
+     * Reserves the memory for the puts, gets and sends the current processor issues to the given processor in every
+     * superstep, so issuing at most that volume does not allocate.
+     *
+     * @param   pid    The processor to communicate with.
+     * @param   volume The communication volume.
+     */
+
+    inline void ReserveCommunication(uint32_t pid, const CommunicationVolume &volume)
+    {
+        BSP::GetInstance().ReserveCommunication(pid, volume);
+    }
+
 
 
 
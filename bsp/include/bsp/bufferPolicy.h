@@ -0,0 +1,137 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_BUFFERPOLICY_H__
+#define __BSPLIB_BUFFERPOLICY_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace BSPInternal
+{
+    /**
+     * The policy that sizes the buffers and queues of the processors. The buffers are sized up front from the
+     * expected h-relation, and keep their largest size over bursty supersteps, but release their memory again after
+     * they have been used sparsely for a sustained amount of supersteps.
+     */
+
+    struct BufferPolicy
+    {
+        BufferPolicy()
+            : hRelation(9064),
+              decay(0.9f),
+              shrinkAfter(64)
+        {
+        }
+
+        /// The amount of bytes a processor is expected to put, get and send in a superstep
+        size_t hRelation;
+        /// The factor the high-water mark of a buffer decays with every time the buffer is cleared
+        float decay;
+        /// The amount of consecutive clears a buffer has to use at most a quarter of its capacity, before its memory
+        /// is released, or 0 to never release memory
+        uint32_t shrinkAfter;
+    };
+
+    /**
+     * Gets the buffer policy of the processors, which is read by the buffers every time they are cleared.
+     *
+     * @return The buffer policy.
+     */
+
+    inline BufferPolicy &GetBufferPolicy()
+    {
+        static BufferPolicy policy;
+        return policy;
+    }
+
+    /**
+     * Tracks the usage of a buffer over the supersteps, as a high-water mark that decays every time the buffer is
+     * cleared, and decides when the buffer should release its memory.
+     */
+
+    class BufferUsage
+    {
+    public:
+
+        BufferUsage()
+            : mHighWater(0),
+              mLowCount(0)
+        {
+        }
+
+        /**
+         * Records the usage of the buffer when it is cleared.
+         *
+         * @param   used     The amount of the buffer that was used.
+         * @param   capacity The capacity of the buffer.
+         * @param   minimum  The capacity the buffer never shrinks below.
+         *
+         * @return The capacity the buffer should shrink to, or 0 when it should keep its memory.
+         */
+
+        size_t Record(size_t used, size_t capacity, size_t minimum)
+        {
+            const BufferPolicy &policy = GetBufferPolicy();
+            mHighWater = std::max(static_cast<float>(used), mHighWater * policy.decay);
+
+            if (policy.shrinkAfter == 0 || used > capacity / 4 || capacity <= minimum)
+            {
+                mLowCount = 0;
+                return 0;
+            }
+
+            if (++mLowCount < policy.shrinkAfter)
+            {
+                return 0;
+            }
+
+            mLowCount = 0;
+            const size_t target = std::max(std::max(static_cast<size_t>(mHighWater * 2), minimum), size_t(1));
+
+            return target < capacity ? target : 0;
+        }
+
+        /**
+         * Gets the high-water mark of the buffer.
+         *
+         * @return The high-water mark.
+         */
+
+        size_t HighWater() const
+        {
+            return static_cast<size_t>(mHighWater);
+        }
+
+    private:
+
+        float mHighWater;
+        uint32_t mLowCount;
+    };
+}
+
+#endif
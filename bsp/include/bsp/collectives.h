@@ -0,0 +1,823 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_COLLECTIVES_H__
+#define __BSPLIB_COLLECTIVES_H__
+
+#include "bsp/bspExt.h"
+
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace BSPInternal
+{
+    /**
+     * The size in bytes a collective publishes for the given values. Values that cannot be copied bytewise are
+     * always published by reference.
+     */
+
+    template< typename tPrimitive >
+    size_t CollectiveSize(size_t count)
+    {
+        return std::is_trivially_copyable< tPrimitive >::value ? count * sizeof(tPrimitive) :
+               std::numeric_limits< size_t >::max();
+    }
+
+    enum
+    {
+        /// The minimal bytes per processor from which a reduction is split in a slice per processor
+        CollectiveSliceBytes = 4096,
+        /// The bytes of a slice that are combined at once, so the partial result stays in the first level cache
+        CollectiveChunkBytes = 4096
+    };
+
+    /**
+     * Combines `src` element wise into `dst`. Arithmetic values are combined in blocks of a cache line with a fixed
+     * amount of elements, which the compiler unrolls and vectorises for the operator.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    BSP_FORCEINLINE void CombineKernel(tPrimitive *BSP_RESTRICT dst, const tPrimitive *BSP_RESTRICT src, size_t count,
+                                       tOp &op, std::true_type)
+    {
+        enum
+        {
+            Width = sizeof(tPrimitive) < BSP_CACHE_LINE_SIZE ? BSP_CACHE_LINE_SIZE / sizeof(tPrimitive) : 1
+        };
+
+        size_t i = 0;
+
+        for (; i + Width <= count; i += Width)
+        {
+            for (size_t j = 0; j < Width; ++j)
+            {
+                dst[i + j] = op(dst[i + j], src[i + j]);
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            dst[i] = op(dst[i], src[i]);
+        }
+    }
+
+    template< typename tPrimitive, typename tOp >
+    BSP_FORCEINLINE void CombineKernel(tPrimitive *BSP_RESTRICT dst, const tPrimitive *BSP_RESTRICT src, size_t count,
+                                       tOp &op, std::false_type)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[i] = op(dst[i], src[i]);
+        }
+    }
+
+    template< typename tPrimitive, typename tOp >
+    BSP_FORCEINLINE void CombineKernel(tPrimitive *dst, const tPrimitive *src, size_t count, tOp &op)
+    {
+        CombineKernel(dst, src, count, op, std::is_arithmetic< tPrimitive >());
+    }
+
+    /**
+     * The kinds of reductions, which differ in the processors whose values are combined, and who receive the result.
+     */
+
+    enum class ReductionKind
+    {
+        Reduce,
+        AllReduce,
+        InclusiveScan,
+        ExclusiveScan
+    };
+
+    /**
+     * The buffers a processor publishes in a sliced reduction.
+     */
+
+    template< typename tPrimitive >
+    struct ReductionBuffers
+    {
+        const tPrimitive *src;
+        tPrimitive *dst;
+    };
+
+    /**
+     * The buffers a processor publishes in an all to all exchange, where the values for processor `pid` start at
+     * `values + offsets[pid]`.
+     */
+
+    template< typename tPrimitive >
+    struct ExchangeBuffers
+    {
+        const tPrimitive *values;
+        const size_t *counts;
+        const size_t *offsets;
+    };
+
+    /**
+     * Publishes the values the current processor sends to every processor in an all to all exchange.
+     */
+
+    template< typename tPrimitive >
+    void BeginExchange(BSP &bsp, const tPrimitive *send, const size_t *sendCounts, std::vector< size_t > &offsets)
+    {
+        const uint32_t nProcs = bsp.NProcs();
+        offsets.resize(nProcs);
+        size_t offset = 0;
+
+        for (uint32_t pid = 0; pid < nProcs; ++pid)
+        {
+            offsets[pid] = offset;
+            offset += sendCounts[pid];
+        }
+
+        const ExchangeBuffers< tPrimitive > own = { send, sendCounts, offsets.data() };
+        bsp.BeginCollective(&own, sizeof(own));
+    }
+
+    /**
+     * Gets the buffers the given processor published in the current exchange.
+     */
+
+    template< typename tPrimitive >
+    const ExchangeBuffers< tPrimitive > &ExchangeData(BSP &bsp, uint32_t pid)
+    {
+        return *static_cast< const ExchangeBuffers< tPrimitive > * >(bsp.CollectiveData(pid));
+    }
+
+    /**
+     * Copies the values all processors send to the current processor into `recv`, ordered by source processor, and
+     * ends the exchange.
+     */
+
+    template< typename tPrimitive >
+    void EndExchange(BSP &bsp, tPrimitive *recv, size_t *recvCounts)
+    {
+        const uint32_t s = bsp.ProcId();
+        const uint32_t nProcs = bsp.NProcs();
+
+        for (uint32_t pid = 0; pid < nProcs; ++pid)
+        {
+            const ExchangeBuffers< tPrimitive > &buffers = ExchangeData< tPrimitive >(bsp, pid);
+            const size_t count = buffers.counts[s];
+            const tPrimitive *values = buffers.values + buffers.offsets[s];
+            recv = std::copy(values, values + count, recv);
+
+            if (recvCounts)
+            {
+                recvCounts[pid] = count;
+            }
+        }
+
+        // The others read the values of this processor in place
+        bsp.EndCollective(true);
+    }
+
+    /**
+     * Combines the values the processors in [begin, end) published in the current collective, in the order of the
+     * processors, so every processor that combines the same range gets the same result.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void CombineCollective(BSP &bsp, uint32_t begin, uint32_t end, tPrimitive *dst, size_t count, tOp &op)
+    {
+        const tPrimitive *first = static_cast< const tPrimitive * >(bsp.CollectiveData(begin));
+        std::copy(first, first + count, dst);
+
+        for (uint32_t pid = begin + 1; pid < end; ++pid)
+        {
+            CombineKernel(dst, static_cast< const tPrimitive * >(bsp.CollectiveData(pid)), count, op);
+        }
+    }
+
+    /**
+     * Performs a reduction where every processor reads the values of all processors it needs. Since `dst` may be
+     * the published `src`, which the others may still read when it is published by reference, the result is then
+     * combined into a temporary first.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void FlatReduction(ReductionKind kind, uint32_t root, const tPrimitive *src, tPrimitive *dst, size_t count,
+                       tOp &op)
+    {
+        BSP &bsp = BSP::GetInstance();
+        const uint32_t s = bsp.ProcId();
+        const uint32_t nProcs = bsp.NProcs();
+        const bool byReference = bsp.BeginCollective(src, CollectiveSize< tPrimitive >(count));
+        const uint32_t end = kind == ReductionKind::Reduce ? (s == root ? nProcs : 0) :
+                             kind == ReductionKind::AllReduce ? nProcs :
+                             kind == ReductionKind::InclusiveScan ? s + 1 : s;
+
+        if (end > 0 && byReference && src == dst)
+        {
+            std::vector< tPrimitive > result(count);
+            CombineCollective(bsp, 0, end, result.data(), count, op);
+            bsp.EndCollective(byReference);
+            std::copy(result.begin(), result.end(), dst);
+            return;
+        }
+
+        if (end > 0)
+        {
+            CombineCollective(bsp, 0, end, dst, count, op);
+        }
+
+        bsp.EndCollective(byReference);
+    }
+
+    /**
+     * Performs a reduction of large vectors by splitting them in a slice per processor. Every processor combines its
+     * slice of the values of all processors, and writes the result directly into the slices of the processors that
+     * receive it, which is a reduce-scatter and allgather in two barriers. Each processor thus reads and writes the
+     * size of the vector, instead of reading it from every processor. Since only the processor of a slice touches it,
+     * in all buffers, the reduction may be in place.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void SlicedReduction(ReductionKind kind, uint32_t root, const tPrimitive *src, tPrimitive *dst, size_t count,
+                         tOp &op, const tPrimitive *identity)
+    {
+        BSP &bsp = BSP::GetInstance();
+        const uint32_t s = bsp.ProcId();
+        const uint32_t nProcs = bsp.NProcs();
+        const ReductionBuffers< tPrimitive > own = { src, dst };
+        bsp.BeginCollective(&own, sizeof(own));
+
+        std::vector< ReductionBuffers< tPrimitive > > buffers(nProcs);
+
+        for (uint32_t pid = 0; pid < nProcs; ++pid)
+        {
+            buffers[pid] = *static_cast< const ReductionBuffers< tPrimitive > * >(bsp.CollectiveData(pid));
+        }
+
+        const size_t begin = count * s / nProcs;
+        const size_t end = count * (s + 1) / nProcs;
+        const size_t chunkSize = std::max< size_t >(1, CollectiveChunkBytes / sizeof(tPrimitive));
+        std::vector< tPrimitive > result(std::min(chunkSize, end - begin));
+        std::vector< tPrimitive > next(kind == ReductionKind::ExclusiveScan ? result.size() : 0);
+
+        for (size_t chunk = begin; chunk < end; chunk += chunkSize)
+        {
+            const size_t size = std::min(chunkSize, end - chunk);
+            std::copy(buffers[0].src + chunk, buffers[0].src + chunk + size, result.begin());
+
+            if (kind == ReductionKind::InclusiveScan)
+            {
+                std::copy(result.begin(), result.begin() + size, buffers[0].dst + chunk);
+            }
+            else if (kind == ReductionKind::ExclusiveScan)
+            {
+                std::fill(buffers[0].dst + chunk, buffers[0].dst + chunk + size, *identity);
+            }
+
+            for (uint32_t pid = 1; pid < nProcs; ++pid)
+            {
+                // The source of a processor is read before its destination is written, since they may be the same
+                if (kind == ReductionKind::ExclusiveScan)
+                {
+                    std::copy(result.begin(), result.begin() + size, next.begin());
+                    CombineKernel(next.data(), buffers[pid].src + chunk, size, op);
+                    std::copy(result.begin(), result.begin() + size, buffers[pid].dst + chunk);
+                    result.swap(next);
+                }
+                else
+                {
+                    CombineKernel(result.data(), buffers[pid].src + chunk, size, op);
+
+                    if (kind == ReductionKind::InclusiveScan)
+                    {
+                        std::copy(result.begin(), result.begin() + size, buffers[pid].dst + chunk);
+                    }
+                }
+            }
+
+            if (kind == ReductionKind::Reduce)
+            {
+                std::copy(result.begin(), result.begin() + size, buffers[root].dst + chunk);
+            }
+            else if (kind == ReductionKind::AllReduce)
+            {
+                for (uint32_t pid = 0; pid < nProcs; ++pid)
+                {
+                    std::copy(result.begin(), result.begin() + size, buffers[pid].dst + chunk);
+                }
+            }
+        }
+
+        // The others write into and read from the buffers of this processor until they are done
+        bsp.EndCollective(true);
+    }
+
+    /**
+     * Performs a reduction, sliced over the processors when the values are large enough.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void Reduction(ReductionKind kind, uint32_t root, const tPrimitive *src, tPrimitive *dst, size_t count, tOp &op,
+                   const tPrimitive *identity = nullptr)
+    {
+        const uint32_t nProcs = BSP::GetInstance().NProcs();
+
+        if (nProcs > 1 && count >= nProcs && count * sizeof(tPrimitive) >= nProcs * CollectiveSliceBytes)
+        {
+            SlicedReduction(kind, root, src, dst, count, op, identity);
+            return;
+        }
+
+        FlatReduction(kind, root, src, dst, count, op);
+
+        if (kind == ReductionKind::ExclusiveScan && BSP::GetInstance().ProcId() == 0)
+        {
+            std::fill(dst, dst + count, *identity);
+        }
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Collective operations, that must be called by all processors in the same order with the same counts. The
+     * processors read each other's values directly from shared memory, instead of exchanging them with puts, so a
+     * collective costs a single barrier when the values of a processor fit in a cache line, and two barriers
+     * otherwise. The collectives do not sync pending communication, and may be used anywhere in a superstep.
+     *
+     * Reductions combine the values in the order of the processors, so they are deterministic, and every processor
+     * computes the same result for floating point values.
+     */
+
+    namespace Collectives
+    {
+        /**
+         * Broadcasts the values of the root processor to all processors.
+         *
+         * @param   values The values, that are overwritten on all processors other than the root.
+         * @param   count  The amount of values.
+         * @param   root   The processor to broadcast from.
+         */
+
+        template< typename tPrimitive >
+        void Broadcast(tPrimitive *values, size_t count, uint32_t root)
+        {
+            BSP &bsp = BSP::GetInstance();
+
+#ifndef BSP_SKIP_CHECKS
+            assert(root < bsp.NProcs());
+#endif
+
+            const bool byReference = bsp.BeginCollective(values, BSPInternal::CollectiveSize< tPrimitive >(count));
+
+            if (bsp.ProcId() != root)
+            {
+                const tPrimitive *rootValues = static_cast< const tPrimitive * >(bsp.CollectiveData(root));
+                std::copy(rootValues, rootValues + count, values);
+            }
+
+            bsp.EndCollective(byReference);
+        }
+
+        template< typename tPrimitive >
+        void Broadcast(tPrimitive &value, uint32_t root)
+        {
+            Broadcast(&value, 1, root);
+        }
+
+        /**
+         * Adds two values.
+         */
+
+        template< typename tPrimitive >
+        struct Sum
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a + b;
+            }
+        };
+
+        /**
+         * Multiplies two values.
+         */
+
+        template< typename tPrimitive >
+        struct Product
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a * b;
+            }
+        };
+
+        /**
+         * Takes the smallest of two values.
+         */
+
+        template< typename tPrimitive >
+        struct Min
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return b < a ? b : a;
+            }
+        };
+
+        /**
+         * Takes the largest of two values.
+         */
+
+        template< typename tPrimitive >
+        struct Max
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a < b ? b : a;
+            }
+        };
+
+        /**
+         * Combines two values with a bitwise and.
+         */
+
+        template< typename tPrimitive >
+        struct BitAnd
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a & b;
+            }
+        };
+
+        /**
+         * Combines two values with a bitwise or.
+         */
+
+        template< typename tPrimitive >
+        struct BitOr
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a | b;
+            }
+        };
+
+        /**
+         * Combines two values with a bitwise exclusive or.
+         */
+
+        template< typename tPrimitive >
+        struct BitXor
+        {
+            BSP_FORCEINLINE tPrimitive operator()(const tPrimitive &a, const tPrimitive &b) const
+            {
+                return a ^ b;
+            }
+        };
+
+        /**
+         * Reduces the values of all processors element wise into the root processor.
+         *
+         * @param   src   The values of the current processor.
+         * @param   dst   The reduced values, only written on the root; this may be `src`.
+         * @param   count The amount of values.
+         * @param   root  The processor to reduce to.
+         * @param   op    The associative operator to combine two values with.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void Reduce(const tPrimitive *src, tPrimitive *dst, size_t count, uint32_t root, tOp op = tOp())
+        {
+#ifndef BSP_SKIP_CHECKS
+            assert(root < BSP::GetInstance().NProcs());
+#endif
+
+            BSPInternal::Reduction(BSPInternal::ReductionKind::Reduce, root, src, dst, count, op);
+        }
+
+        /**
+         * Reduces the value of all processors into the root processor.
+         *
+         * @return The reduced value on the root, and the value of the current processor on the others.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        tPrimitive Reduce(const tPrimitive &value, uint32_t root, tOp op = tOp())
+        {
+            tPrimitive result = value;
+            Reduce(&value, &result, 1, root, op);
+            return result;
+        }
+
+        /**
+         * Reduces the vectors of all processors element wise in place into the root processor.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void Reduce(std::vector< tPrimitive > &values, uint32_t root, tOp op = tOp())
+        {
+            Reduce(values.data(), values.data(), values.size(), root, op);
+        }
+
+        /**
+         * Reduces the values of all processors element wise into every processor.
+         *
+         * @param   src   The values of the current processor.
+         * @param   dst   The reduced values; this may be `src`.
+         * @param   count The amount of values.
+         * @param   op    The associative operator to combine two values with.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void AllReduce(const tPrimitive *src, tPrimitive *dst, size_t count, tOp op = tOp())
+        {
+            BSPInternal::Reduction(BSPInternal::ReductionKind::AllReduce, 0, src, dst, count, op);
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        tPrimitive AllReduce(const tPrimitive &value, tOp op = tOp())
+        {
+            tPrimitive result = value;
+            AllReduce(&value, &result, 1, op);
+            return result;
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void AllReduce(std::vector< tPrimitive > &values, tOp op = tOp())
+        {
+            AllReduce(values.data(), values.data(), values.size(), op);
+        }
+
+        /**
+         * Computes the element wise prefix reduction over the processors, where processor `s` gets the values of
+         * processors `0` up to and including `s` combined.
+         *
+         * @param   src   The values of the current processor.
+         * @param   dst   The prefix reduced values; this may be `src`.
+         * @param   count The amount of values.
+         * @param   op    The associative operator to combine two values with.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void InclusiveScan(const tPrimitive *src, tPrimitive *dst, size_t count, tOp op = tOp())
+        {
+            BSPInternal::Reduction(BSPInternal::ReductionKind::InclusiveScan, 0, src, dst, count, op);
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        tPrimitive InclusiveScan(const tPrimitive &value, tOp op = tOp())
+        {
+            tPrimitive result = value;
+            InclusiveScan(&value, &result, 1, op);
+            return result;
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void InclusiveScan(std::vector< tPrimitive > &values, tOp op = tOp())
+        {
+            InclusiveScan(values.data(), values.data(), values.size(), op);
+        }
+
+        /**
+         * Computes the element wise prefix reduction over the processors, where processor `s` gets the values of
+         * processors `0` up to but excluding `s` combined, and processor `0` gets the identity.
+         *
+         * @param   src      The values of the current processor.
+         * @param   dst      The prefix reduced values; this may be `src`.
+         * @param   count    The amount of values.
+         * @param   identity The identity of the operator.
+         * @param   op       The associative operator to combine two values with.
+         */
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void ExclusiveScan(const tPrimitive *src, tPrimitive *dst, size_t count, const tPrimitive &identity,
+                           tOp op = tOp())
+        {
+            BSPInternal::Reduction(BSPInternal::ReductionKind::ExclusiveScan, 0, src, dst, count, op, &identity);
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        tPrimitive ExclusiveScan(const tPrimitive &value, const tPrimitive &identity, tOp op = tOp())
+        {
+            tPrimitive result = identity;
+            ExclusiveScan(&value, &result, 1, identity, op);
+            return result;
+        }
+
+        template< typename tPrimitive, typename tOp = Sum< tPrimitive > >
+        void ExclusiveScan(std::vector< tPrimitive > &values, const tPrimitive &identity, tOp op = tOp())
+        {
+            ExclusiveScan(values.data(), values.data(), values.size(), identity, op);
+        }
+
+        /**
+         * Gathers the values of all processors into every processor, ordered by processor.
+         *
+         * @param   src   The values of the current processor; this may be `dst + ProcId() * count`.
+         * @param   count The amount of values per processor.
+         * @param   dst   The gathered values, with room for `NProcs() * count` values.
+         */
+
+        template< typename tPrimitive >
+        void AllGather(const tPrimitive *src, size_t count, tPrimitive *dst)
+        {
+            BSP &bsp = BSP::GetInstance();
+            const uint32_t nProcs = bsp.NProcs();
+            const bool byReference = bsp.BeginCollective(src, BSPInternal::CollectiveSize< tPrimitive >(count));
+
+            for (uint32_t pid = 0; pid < nProcs; ++pid)
+            {
+                tPrimitive *block = dst + pid * count;
+                const tPrimitive *values = static_cast< const tPrimitive * >(bsp.CollectiveData(pid));
+
+                if (block != src)
+                {
+                    std::copy(values, values + count, block);
+                }
+            }
+
+            bsp.EndCollective(byReference);
+        }
+
+        template< typename tPrimitive >
+        std::vector< tPrimitive > AllGather(const tPrimitive &value)
+        {
+            std::vector< tPrimitive > values(BSP::GetInstance().NProcs());
+            AllGather(&value, 1, values.data());
+            return values;
+        }
+
+        /**
+         * Exchanges a block of values between every pair of processors. Every processor copies the blocks sent to it
+         * directly from the send buffers of the others, so this costs a single copy per pair of processors and two
+         * barriers, instead of a request per value.
+         *
+         * @param   send       The values to send, ordered by destination processor.
+         * @param   sendCounts The amount of values to send to every processor.
+         * @param   recv       The received values, ordered by source processor, with room for all received values.
+         * @param   recvCounts The amount of values received from every processor, or `nullptr`.
+         *
+         * @pre `send` and `recv` do not overlap.
+         */
+
+        template< typename tPrimitive >
+        void AllToAllV(const tPrimitive *send, const size_t *sendCounts, tPrimitive *recv,
+                       size_t *recvCounts = nullptr)
+        {
+            BSP &bsp = BSP::GetInstance();
+            std::vector< size_t > offsets;
+            BSPInternal::BeginExchange(bsp, send, sendCounts, offsets);
+            BSPInternal::EndExchange(bsp, recv, recvCounts);
+        }
+
+        /**
+         * Exchanges a block of values between every pair of processors, where the amount of received values is
+         * discovered from the send counts of the others during the exchange.
+         *
+         * @param   send       The values to send, ordered by destination processor.
+         * @param   sendCounts The amount of values to send to every processor.
+         * @param   recvCounts The amount of values received from every processor, or `nullptr`.
+         *
+         * @return The received values, ordered by source processor.
+         */
+
+        template< typename tPrimitive >
+        std::vector< tPrimitive > AllToAllV(const std::vector< tPrimitive > &send,
+                                            const std::vector< size_t > &sendCounts,
+                                            std::vector< size_t > *recvCounts = nullptr)
+        {
+            BSP &bsp = BSP::GetInstance();
+            const uint32_t s = bsp.ProcId();
+            const uint32_t nProcs = bsp.NProcs();
+
+#ifndef BSP_SKIP_CHECKS
+            assert(sendCounts.size() == nProcs);
+#endif
+
+            std::vector< size_t > offsets;
+            BSPInternal::BeginExchange(bsp, send.data(), sendCounts.data(), offsets);
+
+            size_t total = 0;
+
+            for (uint32_t pid = 0; pid < nProcs; ++pid)
+            {
+                total += BSPInternal::ExchangeData< tPrimitive >(bsp, pid).counts[s];
+            }
+
+            std::vector< tPrimitive > recv(total);
+
+            if (recvCounts)
+            {
+                recvCounts->resize(nProcs);
+            }
+
+            BSPInternal::EndExchange(bsp, recv.data(), recvCounts ? recvCounts->data() : nullptr);
+            return recv;
+        }
+
+        /**
+         * Exchanges the values in a buffer per destination processor, where most buffers may be empty. The amount of
+         * values every processor receives is discovered from the buffers of the others during the exchange, after
+         * which the values are copied directly from those buffers, which costs two barriers.
+         *
+         * @param   send       The buffer of values to send to every processor.
+         * @param   recv       The received values, concatenated in the order of the source processors. Its memory is
+         *                     reused, so exchanging in every superstep does not allocate once it is large enough.
+         * @param   recvCounts The amount of values received from every processor, or `nullptr`.
+         *
+         * @pre `send` has a buffer for every processor, and does not contain `recv`.
+         */
+
+        template< typename tPrimitive >
+        void SparseExchange(const std::vector< std::vector< tPrimitive > > &send, std::vector< tPrimitive > &recv,
+                            std::vector< size_t > *recvCounts = nullptr)
+        {
+            BSP &bsp = BSP::GetInstance();
+            const uint32_t s = bsp.ProcId();
+            const uint32_t nProcs = bsp.NProcs();
+
+#ifndef BSP_SKIP_CHECKS
+            assert(send.size() == nProcs);
+#endif
+
+            const std::vector< tPrimitive > *own = send.data();
+            bsp.BeginCollective(&own, sizeof(own));
+
+            auto buffer = [&bsp, s](uint32_t pid) -> const std::vector< tPrimitive > &
+            {
+                return (*static_cast< const std::vector< tPrimitive > *const * >(bsp.CollectiveData(pid)))[s];
+            };
+
+            size_t total = 0;
+
+            for (uint32_t pid = 0; pid < nProcs; ++pid)
+            {
+                total += buffer(pid).size();
+            }
+
+            recv.resize(total);
+
+            if (recvCounts)
+            {
+                recvCounts->resize(nProcs);
+            }
+
+            typename std::vector< tPrimitive >::iterator it = recv.begin();
+
+            for (uint32_t pid = 0; pid < nProcs; ++pid)
+            {
+                const std::vector< tPrimitive > &values = buffer(pid);
+                it = std::copy(values.begin(), values.end(), it);
+
+                if (recvCounts)
+                {
+                    (*recvCounts)[pid] = values.size();
+                }
+            }
+
+            // The others read the buffers of this processor in place
+            bsp.EndCollective(true);
+        }
+
+        template< typename tPrimitive >
+        std::vector< tPrimitive > SparseExchange(const std::vector< std::vector< tPrimitive > > &send,
+                                                 std::vector< size_t > *recvCounts = nullptr)
+        {
+            std::vector< tPrimitive > recv;
+            SparseExchange(send, recv, recvCounts);
+            return recv;
+        }
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
+
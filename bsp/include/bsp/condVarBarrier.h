@@ -56,8 +56,11 @@ namespace BSPInternal
             : mCurrentCon(&mConVar1),
               mPreviousCon(&mConVar2),
               mCount(count),
-              mMax(count)
+              mMax(count),
+              mGeneration(0)
         {
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -72,6 +75,9 @@ namespace BSPInternal
         {
             mCount = count;
             mMax = count;
+            mGeneration = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -86,6 +92,25 @@ namespace BSPInternal
          */
 
         void Wait(const std::atomic_bool &aborted)
+        {
+            Wait(aborted, 0);
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, and combines the flags every thread arrives with.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param           flags   The flags this thread arrives with.
+         * @param           id      The identifier of the waiting thread, not needed by this barrier.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t flags, uint32_t /*id*/ = 0)
         {
             std::unique_lock<std::mutex> lock(mMutex);
 
@@ -95,14 +120,33 @@ namespace BSPInternal
                 throw BspAbort("Aborted");
             }
 
+            const size_t myGeneration = mGeneration;
+            mFlags[myGeneration & 1] |= flags;
+
             if (--mCount == 0)
             {
+                mFlags[(myGeneration + 1) & 1] = 0;
+                ++mGeneration;
                 Reset();
             }
             else
             {
-                mCurrentCon->wait(lock);
+                mCurrentCon->wait(lock, [&] {return mGeneration != myGeneration || aborted;});
+
+                if (aborted)
+                {
+                    mCurrentCon->notify_all();
+                    throw BspAbort("Aborted");
+                }
             }
+
+            return mFlags[myGeneration & 1];
+        }
+
+        void NotifyAbort()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCurrentCon->notify_all();
         }
 
     private:
@@ -116,6 +160,10 @@ namespace BSPInternal
 
         size_t mCount;
         size_t mMax;
+        size_t mGeneration;
+
+        /// The combined flags of the current and the previous generation
+        uint32_t mFlags[2];
 
         /**
          * Resets the barrier for reuse.
@@ -0,0 +1,273 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_FUTEXBARRIER_H__
+#define __BSPLIB_FUTEXBARRIER_H__
+
+#include "bsp/bspAbort.h"
+#include "bsp/util.h"
+
+#include <climits>
+#include <atomic>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace BSPInternal
+{
+    /**
+     * A central barrier that spins with an exponential pause backoff, and then sleeps on the generation word. On
+     * Linux the threads sleep on a futex, which wakes up faster than a condition variable and needs no mutex, on
+     * other platforms the threads yield instead.
+     *
+     * The spin budget adapts to the observed imbalance between the threads. When threads are released while spinning
+     * the budget moves towards twice the time they spun, while threads that had to sleep shrink the budget, since
+     * spinning was wasted for them.
+     */
+
+    class FutexBarrier
+    {
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param   count Number of threads to wait for.
+         */
+
+        explicit FutexBarrier(uint32_t count) :
+            mCount(count),
+            mSpaces(count),
+            mSpinBudget(msInitialSpinBudget),
+            mGeneration(0),
+            mSleepers(0)
+        {
+            mFlags[0] = 0;
+            mFlags[1] = 0;
+        }
+
+        /**
+         * Sets the size of the barrier, thus the number of threads to wait for on a sync point.
+         *
+         * @param   count Number of threads to wait on.
+         *
+         * @post The amount of threads the barriers waits on equals count.
+         */
+
+        void SetSize(uint32_t count)
+        {
+            mCount = count;
+            mSpaces = count;
+            mSpinBudget = msInitialSpinBudget;
+            mGeneration = 0;
+            mSleepers = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, however the process can be aborted when `aborted` equals to
+         * true.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        void Wait(const std::atomic_bool &aborted)
+        {
+            Wait(aborted, 0);
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, and combines the flags every thread arrives with.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param           flags   The flags this thread arrives with.
+         * @param           id      The identifier of the waiting thread, not needed by this barrier.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t flags, uint32_t /*id*/ = 0)
+        {
+            const uint32_t myGeneration = mGeneration;
+            std::atomic_uint_fast32_t &generationFlags = mFlags[myGeneration & 1];
+
+            if (aborted)
+            {
+                throw BspAbort("Aborted");
+            }
+
+            if (flags)
+            {
+                generationFlags |= flags;
+            }
+
+            if (!--mSpaces)
+            {
+                mSpaces = mCount;
+                mFlags[(myGeneration + 1) & 1] = 0;
+                ++mGeneration;
+
+                if (mSleepers)
+                {
+                    WakeAll();
+                }
+            }
+            else
+            {
+                WaitForRelease(aborted, myGeneration);
+            }
+
+            if (aborted)
+            {
+                throw BspAbort("Aborted");
+            }
+
+            return static_cast<uint32_t>(generationFlags);
+        }
+
+        void NotifyAbort()
+        {
+            ++mGeneration;
+            WakeAll();
+        }
+
+    private:
+
+        /// The spin budget in pause instructions, a few microseconds on current processors
+        static const uint32_t msInitialSpinBudget = 1 << 14;
+        static const uint32_t msMinSpinBudget = 1 << 8;
+        static const uint32_t msMaxSpinBudget = 1 << 22;
+
+        /// The maximum amount of pause instructions between two checks of the generation
+        static const uint32_t msMaxBackoff = 1 << 6;
+
+        /// The amount of threads to wait for in total
+        uint32_t mCount;
+
+        /// The amount of threads filling the barrier currently, written by every arriving thread
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mSpaces;
+
+        /// The combined flags of the current and the previous generation
+        std::atomic_uint_fast32_t mFlags[2];
+
+        /// The amount of pause instructions to spin before sleeping
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic< uint32_t > mSpinBudget;
+
+        /// The current waiting generation, the sleeping threads wait on this word
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic< uint32_t > mGeneration;
+
+        /// The amount of threads that are sleeping or about to sleep, so the release can skip the wake up otherwise
+        std::atomic< uint32_t > mSleepers;
+
+        void WaitForRelease(const std::atomic_bool &aborted, uint32_t myGeneration)
+        {
+            const uint32_t budget = mSpinBudget.load(std::memory_order_relaxed);
+            uint32_t spun = 0;
+            uint32_t backoff = 1;
+
+            while (mGeneration == myGeneration)
+            {
+                if (spun >= budget)
+                {
+                    SleepUntilRelease(aborted, myGeneration);
+                    mSpinBudget.store(budget - budget / 8 > msMinSpinBudget ? budget - budget / 8 : msMinSpinBudget,
+                                      std::memory_order_relaxed);
+                    return;
+                }
+
+                for (uint32_t i = 0; i < backoff; ++i)
+                {
+                    BSPUtil::Pause();
+                }
+
+                spun += backoff;
+
+                if (backoff < msMaxBackoff)
+                {
+                    backoff <<= 1;
+                }
+                else
+                {
+                    if (aborted)
+                    {
+                        throw BspAbort("Aborted");
+                    }
+
+                    std::this_thread::yield();
+                }
+            }
+
+            // Move the budget an eighth of the way towards twice the time we spun
+            const uint64_t target = 2 * static_cast<uint64_t>(spun);
+            const uint64_t adapted = target > budget ? budget + (target - budget) / 8 : budget - (budget - target) / 8;
+            mSpinBudget.store(static_cast<uint32_t>(adapted < msMinSpinBudget ? msMinSpinBudget :
+                                                    adapted > msMaxSpinBudget ? msMaxSpinBudget : adapted),
+                              std::memory_order_relaxed);
+        }
+
+        void SleepUntilRelease(const std::atomic_bool &aborted, uint32_t myGeneration)
+        {
+            ++mSleepers;
+
+            while (mGeneration == myGeneration && !aborted)
+            {
+#if defined(__linux__)
+                syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mGeneration), FUTEX_WAIT_PRIVATE, myGeneration, nullptr,
+                        nullptr, 0);
+#else
+                std::this_thread::yield();
+#endif
+            }
+
+            --mSleepers;
+        }
+
+        void WakeAll()
+        {
+#if defined(__linux__)
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mGeneration), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+                    nullptr, 0);
+#endif
+        }
+
+        static_assert(sizeof(std::atomic< uint32_t >) == sizeof(uint32_t), "The generation must be usable as a futex word");
+    };
+}
+
+#endif
@@ -228,7 +228,18 @@ public:
         });
     }
 
-    void RecordProcessorsData(uint32_t pid, const std::vector<ProcessorData> &processorsData)
+    /**
+     * Whether the queues of all processors are read when recording, in which case a sync may not return before every
+     * processor has recorded them.
+     */
+
+    bool RecordsProcessorsData() const
+    {
+        return EitherOr(tHistoryType, HistoryType::BarData, HistoryType::MatrixData) &&
+               EitherOr(tHistoryType, HistoryType::MessageSize, HistoryType::MessageCount);
+    }
+
+    void RecordProcessorsData(uint32_t pid, const tProcessorsData &processorsData)
     {
         constexpr bool barOrMatrixData = EitherOr(tHistoryType, HistoryType::BarData, HistoryType::MatrixData);
         constexpr bool sizeOrCountData = EitherOr(tHistoryType, HistoryType::MessageSize, HistoryType::MessageCount);
@@ -252,23 +263,20 @@ public:
                     {
                         BSPUtil::StaticIf< Contains(tHistoryType, HistoryType::MessageSize) >([&data, pid, &receiveBytes]
                         {
-                            for (auto it = data.putRequests[pid].CBegin(), end = data.putRequests[pid].CEnd(); it != end; ++it)
+                            for (auto it = data.putRequests[data.putSet][pid].CBegin(), end = data.putRequests[data.putSet][pid].CEnd(); it != end; it += it->Records())
                             {
-                                receiveBytes += it->size;
+                                receiveBytes += it->Size();
                             }
 
 
-                            for (auto it = data.tmpSendRequests[pid].CBegin(), end = data.tmpSendRequests[pid].CEnd(); it != end; ++it)
-                            {
-                                receiveBytes += it->bufferSize;
-                                receiveBytes += it->tagSize;
-                            }
+                            // The send buffer holds the payloads and tags of the messages
+                            receiveBytes += data.tmpSendBufferStacks[data.sendSet][pid].Size();
                         });
 
                         BSPUtil::StaticIf< Contains(tHistoryType, HistoryType::MessageCount) >([&data, pid, &receiveCount, &sendCount]
                         {
-                            receiveCount += data.putRequests[pid].GetSize();
-                            receiveCount += data.tmpSendRequests[pid].GetSize();
+                            receiveCount += data.putRequests[data.putSet][pid].PutCount();
+                            receiveCount += data.tmpSendRequests[data.sendSet][pid].GetSize();
                             sendCount += data.getRequests[pid].GetSize();
                         });
                     });
@@ -308,43 +316,32 @@ public:
                     {
                         BSPUtil::StaticIf< Both(tHistoryType, HistoryType::BarData, HistoryType::MatrixData) >([&data, target, &sendBytes, &sendSizes]
                         {
-                            for (auto it = data.putRequests[target].CBegin(), end = data.putRequests[target].CEnd(); it != end; ++it)
+                            for (auto it = data.putRequests[data.putSet][target].CBegin(), end = data.putRequests[data.putSet][target].CEnd(); it != end; it += it->Records())
                             {
-                                sendBytes += it->size;
-                                sendSizes[target] += it->size;
+                                sendBytes += it->Size();
+                                sendSizes[target] += it->Size();
                             }
 
-                            for (auto it = data.tmpSendRequests[target].CBegin(), end = data.tmpSendRequests[target].CEnd(); it != end; ++it)
-                            {
-                                sendBytes += it->bufferSize;
-                                sendBytes += it->tagSize;
-                                sendSizes[target] += it->bufferSize + it->tagSize;
-                            }
+                            sendBytes += data.tmpSendBufferStacks[data.sendSet][target].Size();
+                            sendSizes[target] += data.tmpSendBufferStacks[data.sendSet][target].Size();
                         }).template
                         ElseIf< Contains(tHistoryType, HistoryType::BarData) >([&data, target, &sendBytes ]
                         {
-                            for (auto it = data.putRequests[target].CBegin(), end = data.putRequests[target].CEnd(); it != end; ++it)
+                            for (auto it = data.putRequests[data.putSet][target].CBegin(), end = data.putRequests[data.putSet][target].CEnd(); it != end; it += it->Records())
                             {
-                                sendBytes += it->size;
+                                sendBytes += it->Size();
                             }
 
-                            for (auto it = data.tmpSendRequests[target].CBegin(), end = data.tmpSendRequests[target].CEnd(); it != end; ++it)
-                            {
-                                sendBytes += it->bufferSize;
-                                sendBytes += it->tagSize;
-                            }
+                            sendBytes += data.tmpSendBufferStacks[data.sendSet][target].Size();
                         }).
                         Else([&data, target, &sendSizes]
                         {
-                            for (auto it = data.putRequests[target].CBegin(), end = data.putRequests[target].CEnd(); it != end; ++it)
+                            for (auto it = data.putRequests[data.putSet][target].CBegin(), end = data.putRequests[data.putSet][target].CEnd(); it != end; it += it->Records())
                             {
-                                sendSizes[target] += it->size;
+                                sendSizes[target] += it->Size();
                             }
 
-                            for (auto it = data.tmpSendRequests[target].CBegin(), end = data.tmpSendRequests[target].CEnd(); it != end; ++it)
-                            {
-                                sendSizes[target] += it->bufferSize + it->tagSize;
-                            }
+                            sendSizes[target] += data.tmpSendBufferStacks[data.sendSet][target].Size();
                         });
                     });
 
@@ -361,8 +358,8 @@ public:
 
                         BSPUtil::StaticIf< Contains(tHistoryType, HistoryType::MessageCount) >([&data, pid, &sendCount, &receiveCount]
                         {
-                            sendCount += data.putRequests[pid].GetSize();
-                            sendCount += data.tmpSendRequests[pid].GetSize();
+                            sendCount += data.putRequests[data.putSet][pid].PutCount();
+                            sendCount += data.tmpSendRequests[data.sendSet][pid].GetSize();
                             receiveCount += data.getRequests[pid].GetSize();
                         });
                     });
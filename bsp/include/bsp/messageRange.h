@@ -0,0 +1,132 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_MESSAGERANGE_H__
+#define __BSPLIB_MESSAGERANGE_H__
+
+#include "bsp/messageView.h"
+#include "bsp/bspClass.h"
+
+#include <iterator>
+
+namespace BSPInternal
+{
+    /**
+     * An input iterator over the messages in the receive queue of the current processor. Dereferencing returns the
+     * message view by value, so it does not satisfy the forward iterator requirements.
+     */
+
+    class MessageIterator
+    {
+    public:
+
+        typedef std::input_iterator_tag iterator_category;
+        typedef MessageView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef MessageView reference;
+
+        MessageIterator(BSP &bsp, size_t index)
+            : mBSP(&bsp),
+              mIndex(index)
+        {
+        }
+
+        MessageView operator*() const
+        {
+            return mBSP->PeekMessage(mIndex);
+        }
+
+        MessageIterator &operator++()
+        {
+            ++mIndex;
+            return *this;
+        }
+
+        MessageIterator operator++(int)
+        {
+            MessageIterator it(*this);
+            ++mIndex;
+            return it;
+        }
+
+        bool operator==(const MessageIterator &other) const
+        {
+            return mIndex == other.mIndex;
+        }
+
+        bool operator!=(const MessageIterator &other) const
+        {
+            return mIndex != other.mIndex;
+        }
+
+    private:
+
+        BSP *mBSP;
+        size_t mIndex;
+    };
+
+    /**
+     * A range over the messages that have not yet been moved out of the receive queue. Iterating the range does not
+     * advance the queue cursor.
+     */
+
+    class MessageRange
+    {
+    public:
+
+        explicit MessageRange(BSP &bsp)
+            : mBSP(&bsp)
+        {
+        }
+
+        MessageIterator begin() const
+        {
+            return MessageIterator(*mBSP, mBSP->GetMessageCursor());
+        }
+
+        MessageIterator end() const
+        {
+            return MessageIterator(*mBSP, mBSP->GetMessageCount());
+        }
+
+        size_t size() const
+        {
+            return mBSP->GetMessageCount() - mBSP->GetMessageCursor();
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+
+        BSP *mBSP;
+    };
+}
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_MESSAGEVIEW_H__
+#define __BSPLIB_MESSAGEVIEW_H__
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <cstddef>
+
+namespace BSPInternal
+{
+    /**
+     * A view on a received message. The tag and payload point directly into the receive buffers, and stay valid
+     * until the next Sync. Note that the memory is not guaranteed to be aligned for any type.
+     */
+
+    struct MessageView
+    {
+        const void *tag;
+        const void *payload;
+        size_t tagSize;
+        size_t size;
+
+        /**
+         * Copies the tag of the message into a value of the given type.
+         *
+         * @return The tag.
+         */
+
+        template< typename tPrimitive >
+        tPrimitive Tag() const
+        {
+#ifndef BSP_SKIP_CHECKS
+            assert(sizeof(tPrimitive) <= tagSize);
+#endif
+
+            tPrimitive value;
+            memcpy(&value, tag, sizeof(tPrimitive));
+            return value;
+        }
+
+        /**
+         * Copies a value of the payload, where the payload is seen as an array of the given type.
+         *
+         * @param   index The index of the value in the payload.
+         *
+         * @return The value.
+         */
+
+        template< typename tPrimitive >
+        tPrimitive Payload(size_t index) const
+        {
+#ifndef BSP_SKIP_CHECKS
+            assert((index + 1) * sizeof(tPrimitive) <= size);
+#endif
+
+            tPrimitive value;
+            memcpy(&value, static_cast< const char * >(payload) + index * sizeof(tPrimitive), sizeof(tPrimitive));
+            return value;
+        }
+
+        /**
+         * Copies the values of the payload into the given array.
+         *
+         * @param   dst      The array to copy into.
+         * @param   maxCount The maximum amount of values to copy.
+         *
+         * @return The amount of values copied.
+         */
+
+        template< typename tPrimitive >
+        size_t CopyPayload(tPrimitive *dst, size_t maxCount) const
+        {
+            const size_t count = std::min(Count< tPrimitive >(), maxCount);
+            memcpy(dst, payload, count * sizeof(tPrimitive));
+            return count;
+        }
+
+        template< typename tPrimitive >
+        size_t Count() const
+        {
+            return size / sizeof(tPrimitive);
+        }
+    };
+}
+
+#endif
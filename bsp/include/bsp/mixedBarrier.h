@@ -27,9 +27,12 @@
 #ifndef __BSPLIB_MIXEDBARRIER_H__
 #define __BSPLIB_MIXEDBARRIER_H__
 
+#ifndef BSP_SPIN_ITERATIONS
 #define BSP_SPIN_ITERATIONS 20000
+#endif
 
 #include "bsp/bspAbort.h"
+#include "bsp/util.h"
 
 #include <condition_variable>
 #include <atomic>
@@ -58,8 +61,11 @@ namespace BSPInternal
               mPreviousCon(&mConVar2),
               mCount(count),
               mMax(count),
-              mSpaces(count)
+              mSpaces(count),
+              mGeneration(0)
         {
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -75,6 +81,9 @@ namespace BSPInternal
             mCount = count;
             mMax = count;
             mSpaces = count;
+            mGeneration = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
         }
 
         /**
@@ -89,17 +98,45 @@ namespace BSPInternal
          */
 
         void Wait(const std::atomic_bool &aborted)
+        {
+            Wait(aborted, 0);
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, and combines the flags every thread arrives with. The flags
+         * of a generation are kept until the next generation has been completed, so every thread can read them after
+         * it has been released.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param           flags   The flags this thread arrives with.
+         * @param           id      The identifier of the waiting thread, not needed by this barrier.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t flags, uint32_t /*id*/ = 0)
         {
             const uint32_t myGeneration = mGeneration;
+            std::atomic_uint_fast32_t &generationFlags = mFlags[myGeneration & 1];
 
             if (aborted)
             {
                 Abort();
             }
 
+            if (flags)
+            {
+                generationFlags |= flags;
+            }
+
             if (!--mSpaces)
             {
                 mSpaces = mMax;
+                mFlags[(myGeneration + 1) & 1] = 0;
                 std::lock_guard< std::mutex > condVarLoc(mCondVarMutex);
                 ++mGeneration;
                 Reset();
@@ -128,6 +165,8 @@ namespace BSPInternal
                 mCurrentCon->notify_all();
                 throw BspAbort("Aborted");
             }
+
+            return static_cast<uint32_t>(generationFlags);
         }
 
         void NotifyAbort()
@@ -148,8 +187,13 @@ namespace BSPInternal
         uint32_t mCount;
         uint32_t mMax;
 
-        std::atomic_uint_fast32_t mSpaces;
-        std::atomic_uint_fast32_t mGeneration;
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mSpaces;
+
+        /// The combined flags of the current and the previous generation
+        std::atomic_uint_fast32_t mFlags[2];
+
+        /// On its own cache line, since the waiting threads spin on it
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mGeneration;
 
         void Reset()
         {
@@ -27,60 +27,315 @@
 #ifndef __BSPLIB_PROCESSORDATA_H__
 #define __BSPLIB_PROCESSORDATA_H__
 
+#include "bsp/alignedAllocator.h"
 #include "bsp/registerMapType.h"
 #include "bsp/stackAllocator.h"
 #include "bsp/requestVector.h"
 #include "bsp/barrierType.h"
 
-struct ProcessorData
+#include <cstddef>
+
+namespace BSPInternal
+{
+    /**
+     * A contiguous run of received messages, that are read in place from the send queue of the sending processor.
+     */
+
+    struct SendSegment
+    {
+        const RequestVector< SendRequest > *requests;
+        const StackAllocator *buffer;
+
+        /// The index in the receive queue one past the last message of this segment
+        size_t end;
+    };
+
+    /**
+     * The kinds of requests a processor can have pending at a sync. Every processor contributes its own flags on
+     * arrival at the first barrier of the sync, and leaves the barrier with the flags of all processors combined.
+     */
+
+    enum SyncFlags : uint32_t
+    {
+        PutRequestsFlag = 0x01,
+        HPPutRequestsFlag = 0x02,
+        GetRequestsFlag = 0x04,
+        HPGetRequestsFlag = 0x08,
+        PushRequestsFlag = 0x10,
+        PopRequestsFlag = 0x20,
+        SendRequestsFlag = 0x40,
+        TagSizeUpdateFlag = 0x80,
+        /// A processor pops padding, which has to be matched to the pops of the other processors
+        PaddedPopRequestsFlag = 0x100
+    };
+
+    /**
+     * The communication a processor expects to issue to another processor in a superstep.
+     */
+
+    struct CommunicationVolume
+    {
+        CommunicationVolume()
+            : puts(0),
+              putBytes(0),
+              gets(0),
+              sends(0),
+              sendBytes(0)
+        {
+        }
+
+        /// The amount of buffered puts
+        size_t puts;
+        /// The amount of bytes of the buffered puts
+        size_t putBytes;
+        /// The amount of buffered gets
+        size_t gets;
+        /// The amount of messages
+        size_t sends;
+        /// The amount of bytes of the messages, including their tags
+        size_t sendBytes;
+    };
+
+    /**
+     * The data a processor publishes to the others in a collective operation. Small data is copied into the slot, so
+     * the publishing processor may change its own copy as soon as all processors have published theirs. Larger data
+     * is published by reference.
+     */
+
+    struct alignas(BSP_CACHE_LINE_SIZE) CollectiveSlot
+    {
+        enum
+        {
+            InlineCapacity = 64
+        };
+
+        const void *data;
+        alignas(std::max_align_t) unsigned char bytes[InlineCapacity];
+    };
+}
+
+/**
+ * The data of a single processor. The processors are stored next to each other, so every processor starts on its own
+ * cache line. The fields the processor touches in every superstep come first, followed by the queues, which each start
+ * on their own cache line since the queues to and from the other processors are written by different threads.
+ * Fields that are rarely touched come last.
+ */
+
+struct alignas(BSP_CACHE_LINE_SIZE) ProcessorData
 {
     ProcessorData()
         : sendReceivedIndex(0),
-          registerCount(0),
-          newTagSize(0),
           sendRequestsSize(0),
+          sendSegmentIndex(0),
+          sendSet(0),
+          putSet(0),
+          newTagSize(0),
+          registerCount(0),
           pushRequestsSize(0),
           popRequestsSize(0),
-          putBufferStack(9064),
-          getBufferStack(9064),
-          sendBufferStack(9064)
+          putsReservePending(false),
+          sendsReservePending(false),
+          collectiveSet(0),
+          syncGeneration(0),
+          syncPending(false)
+    {
+    }
+
+    /**
+     * Allocates the buffers and queues of the processor for a program with the given amount of processors. This is
+     * called by the processor itself, after it has been placed on its CPU, so the memory is first touched by, and
+     * thus placed on the NUMA node of, the thread that writes it in every superstep. Buffers that already have the
+     * right size are kept. The buffers are sized for the h-relation of the buffer policy, where the sends are
+     * expected to be spread evenly over the processors.
+     *
+     * @param   nProcs The amount of processors.
+     */
+
+    void Allocate(uint32_t nProcs)
     {
-        sendRequests.Reserve(9064);
-        pushRequests.Reserve(9064);
-        popRequests.Reserve(9064);
+        const size_t hRelation = BSPInternal::GetBufferPolicy().hRelation;
+
+        if (putRequests[0].size() != nProcs)
+        {
+            putBufferStacks[0] = BSPInternal::StackAllocator(hRelation);
+            putBufferStacks[1] = BSPInternal::StackAllocator(hRelation);
+            getBufferStack = BSPInternal::StackAllocator(hRelation);
+            pushRequests.Reserve(9064);
+            popRequests.Reserve(9064);
 
+            putRequests[0].resize(nProcs);
+            putRequests[1].resize(nProcs);
+            hpPutRequests.resize(nProcs);
+            getRequests.resize(nProcs);
+            hpGetRequests.resize(nProcs);
+            bufferedGetRequests.resize(nProcs);
+            tmpSendRequests[0].resize(nProcs);
+            tmpSendRequests[1].resize(nProcs);
+            tmpSendBufferStacks[0].resize(nProcs);
+            tmpSendBufferStacks[1].resize(nProcs);
+            sendSegments.reserve(nProcs);
+        }
+
+        putBufferStacks[0].Reserve(hRelation);
+        putBufferStacks[1].Reserve(hRelation);
+        getBufferStack.Reserve(hRelation);
+
+        for (uint32_t target = 0; target < nProcs; ++target)
+        {
+            tmpSendBufferStacks[0][target].Reserve(hRelation / nProcs);
+            tmpSendBufferStacks[1][target].Reserve(hRelation / nProcs);
+        }
+    }
+
+    /**
+     * Reserves the queues and buffers for the given communication to a processor in every superstep. The puts and
+     * sends are double buffered, and the other set may still be read by the receivers, so it is reserved when the
+     * processor switches to it.
+     *
+     * @param   pid    The processor to communicate with.
+     * @param   nProcs The amount of processors.
+     * @param   volume The communication volume.
+     */
+
+    void Reserve(uint32_t pid, uint32_t nProcs, const BSPInternal::CommunicationVolume &volume)
+    {
+        reservations.resize(nProcs);
+        reservations[pid] = volume;
+
+        getRequests[pid].Reserve(volume.gets);
+        ReservePuts();
+        ReserveSends();
+        putsReservePending = true;
+        sendsReservePending = true;
+    }
+
+    /**
+     * Reserves the current put set for the reserved communication. Since all puts share one buffer, it is reserved
+     * for the puts to all processors together.
+     */
+
+    void ReservePuts()
+    {
+        size_t putBytes = 0;
+
+        for (uint32_t target = 0; target < reservations.size(); ++target)
+        {
+            putRequests[putSet][target].Reserve(reservations[target].puts);
+            putBytes += reservations[target].putBytes;
+        }
+
+        putBufferStacks[putSet].Reserve(putBytes);
+    }
+
+    /**
+     * Reserves the current send set for the reserved communication.
+     */
+
+    void ReserveSends()
+    {
+        for (uint32_t target = 0; target < reservations.size(); ++target)
+        {
+            tmpSendRequests[sendSet][target].Reserve(reservations[target].sends);
+            tmpSendBufferStacks[sendSet][target].Reserve(reservations[target].sendBytes);
+        }
+    }
+
+    /**
+     * Resets the processor to the state of a new BSP program, while keeping the memory of its buffers and queues.
+     */
+
+    void Reset()
+    {
+        sendReceivedIndex = 0;
+        sendRequestsSize = 0;
+        sendSegmentIndex = 0;
+        sendSet = 0;
+        putSet = 0;
+        newTagSize = 0;
+        registerCount = 0;
+        pushRequestsSize = 0;
+        popRequestsSize = 0;
+        sendSegments.clear();
+        reservations.clear();
+        putsReservePending = false;
+        sendsReservePending = false;
+        collectiveSet = 0;
+        syncGeneration = 0;
+        syncPending = false;
+
+        putBufferStacks[0].Clear();
+        putBufferStacks[1].Clear();
+        getBufferStack.Clear();
+        ClearAll(tmpSendBufferStacks[0]);
+        ClearAll(tmpSendBufferStacks[1]);
+        ClearAll(putRequests[0]);
+        ClearAll(putRequests[1]);
+        ClearAll(hpPutRequests);
+        ClearAll(getRequests);
+        ClearAll(hpGetRequests);
+        ClearAll(bufferedGetRequests);
+        ClearAll(tmpSendRequests[0]);
+        ClearAll(tmpSendRequests[1]);
+        pushRequests.Clear();
+        popRequests.Clear();
+
+        threadRegisters.Clear();
+        freeRegisters.clear();
     }
 
     uint32_t sendReceivedIndex;
-    uint32_t registerCount;
-    uint32_t newTagSize;
     uint32_t sendRequestsSize;
+    uint32_t sendSegmentIndex;
+    uint32_t sendSet;
+    uint32_t putSet;
+    uint32_t newTagSize;
+    uint32_t registerCount;
     uint32_t pushRequestsSize;
     uint32_t popRequestsSize;
-    BSPInternal::StackAllocator putBufferStack;
+    std::vector<BSPInternal::SendSegment> sendSegments;
+
+    BSPInternal::StackAllocator putBufferStacks[2];
     BSPInternal::StackAllocator getBufferStack;
-    BSPInternal::StackAllocator sendBufferStack;
-    std::vector<BSPInternal::StackAllocator> tmpSendBufferStacks;
-    BSPUtil::TicTimer startTimer;
-    BSPUtil::TicTimer ticTimer;
-    std::vector<BSPInternal::RequestVector< BSPInternal::PutRequest >> putRequests;
-    std::vector<BSPInternal::RequestVector< BSPInternal::GetRequest >> getRequests;
-    std::vector<BSPInternal::RequestVector< BSPInternal::BufferedGetRequest >> bufferedGetRequests;
-    std::vector<BSPInternal::RequestVector< BSPInternal::SendRequest >> tmpSendRequests;
-    BSPInternal::RequestVector< BSPInternal::SendRequest > sendRequests;
+    BSPInternal::CacheAlignedVector<BSPInternal::StackAllocator> tmpSendBufferStacks[2];
+    BSPInternal::CacheAlignedVector<BSPInternal::PutRequestVector> putRequests[2];
+    BSPInternal::CacheAlignedVector<BSPInternal::RequestVector< BSPInternal::HPPutRequest >> hpPutRequests;
+    BSPInternal::CacheAlignedVector<BSPInternal::RequestVector< BSPInternal::GetRequest >> getRequests;
+    BSPInternal::CacheAlignedVector<BSPInternal::RequestVector< BSPInternal::GetRequest >> hpGetRequests;
+    BSPInternal::CacheAlignedVector<BSPInternal::RequestVector< BSPInternal::BufferedGetRequest >> bufferedGetRequests;
+    BSPInternal::CacheAlignedVector<BSPInternal::RequestVector< BSPInternal::SendRequest >> tmpSendRequests[2];
     BSPInternal::RequestVector< BSPInternal::PushRequest > pushRequests;
     BSPInternal::RequestVector< BSPInternal::PopRequest > popRequests;
+
+    BSPUtil::TicTimer startTimer;
+    BSPUtil::TicTimer ticTimer;
     tRegisterMap threadRegisters;
+    /// The global IDs of popped registers, which are reused by the next pushes. Since all processors push and pop
+    /// their registers in the same order, the IDs stay the same on all processors.
+    std::vector< uint32_t > freeRegisters;
+    /// The communication reserved per processor, and whether the other put and send sets still have to be reserved
+    std::vector< BSPInternal::CommunicationVolume > reservations;
+    bool putsReservePending;
+    bool sendsReservePending;
+    /// The slots of the collective operations, which alternate between consecutive collectives, since the others may
+    /// still read the slot of the previous collective while this processor publishes the next one
+    BSPInternal::CollectiveSlot collectiveSlots[2];
+    uint32_t collectiveSet;
+    /// The generation of the split phase sync the processor has begun, but not yet ended
+    uint32_t syncGeneration;
+    bool syncPending;
+
+private:
 
-    struct
+    template< typename tContainer >
+    static void ClearAll(tContainer &container)
     {
-        bool hasPutRequests = false;
-        bool hasGetRequests = false;
-        bool hasPushRequests = false;
-        bool hasPopRequests = false;
-        bool hasSendRequests = false;
-        bool hasTagSizeUpdate = false;
-    } syncBools;
+        for (auto &element : container)
+        {
+            element.Clear();
+        }
+    }
 };
 
+typedef BSPInternal::CacheAlignedVector< ProcessorData > tProcessorsData;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_REGISTER_H__
+#define __BSPLIB_REGISTER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BSPInternal
+{
+    /**
+     * A handle to a pushed register, that refers to the register by its global ID. Communication through the handle
+     * does not have to look up the global ID from the address of the register. Like the register itself, the handle
+     * can be used after the next Sync, until the register is popped.
+     *
+     * @tparam  tPrimitive The type of the elements in the register.
+     */
+
+    template< typename tPrimitive >
+    class Register
+    {
+    public:
+
+        Register()
+            : mData(nullptr),
+              mCount(0),
+              mGlobalId((uint32_t)(-1))
+        {
+        }
+
+        /**
+         * Constructor.
+         *
+         * @param [in,out]  data The local address of the register.
+         * @param   count        The amount of elements in the register.
+         * @param   globalId     The global ID of the register.
+         */
+
+        Register(tPrimitive *data, size_t count, uint32_t globalId)
+            : mData(data),
+              mCount(count),
+              mGlobalId(globalId)
+        {
+        }
+
+        /**
+         * Gets the local address of the register.
+         *
+         * @return The local address.
+         */
+
+        tPrimitive *Data() const
+        {
+            return mData;
+        }
+
+        /**
+         * Gets the amount of elements the register was pushed with on this processor.
+         *
+         * @return The amount of elements.
+         */
+
+        size_t Size() const
+        {
+            return mCount;
+        }
+
+        uint32_t GlobalId() const
+        {
+            return mGlobalId;
+        }
+
+    private:
+
+        tPrimitive *mData;
+        size_t mCount;
+        uint32_t mGlobalId;
+    };
+}
+
+#endif
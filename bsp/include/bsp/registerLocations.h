@@ -0,0 +1,141 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_REGISTERLOCATIONS_H__
+#define __BSPLIB_REGISTERLOCATIONS_H__
+
+#include "bsp/requests.h"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace BSPInternal
+{
+    /**
+     * The local locations of the registers of a thread by global ID, shared by the register maps. Also keeps the
+     * earlier registrations of registers that were pushed again, such as padding, so they return when popped.
+     */
+
+    class RegisterLocations
+    {
+    public:
+
+        BSP_FORCEINLINE const void *Get(uint32_t globalId) const
+        {
+            return mLocations[globalId];
+        }
+
+        void Set(uint32_t globalId, const void *reg)
+        {
+            // Popped global IDs are reused, so the register may take an existing slot
+            if (globalId >= mLocations.size())
+            {
+                mLocations.resize(globalId + 1);
+            }
+
+            mLocations[globalId] = reg;
+        }
+
+        /**
+         * Hides the current registration of a register that is pushed again.
+         *
+         * @param   reg  The register.
+         * @param   info The information of the current registration.
+         */
+
+        void Shadow(const void *reg, const RegisterInfo &info)
+        {
+            mShadowed.emplace_back(reg, info);
+        }
+
+        /**
+         * Restores the registration of the given register that was hidden by pushing it again, if any.
+         *
+         * @param   reg       The register.
+         * @param [out] info  The information of the restored registration.
+         *
+         * @return True if a registration was restored.
+         */
+
+        bool RestoreShadowed(const void *reg, RegisterInfo &info)
+        {
+            for (auto shadowed = mShadowed.rbegin(); shadowed != mShadowed.rend(); ++shadowed)
+            {
+                if (shadowed->first == reg)
+                {
+                    info = shadowed->second;
+                    mShadowed.erase(std::next(shadowed).base());
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * Erases the registration of the given register with the given global ID, that was hidden by pushing the
+         * register again.
+         *
+         * @param   reg         The register.
+         * @param   globalId    The global ID of the registration.
+         *
+         * @return True if the registration was found.
+         */
+
+        bool EraseShadowed(const void *reg, uint32_t globalId)
+        {
+            for (auto shadowed = mShadowed.begin(); shadowed != mShadowed.end(); ++shadowed)
+            {
+                if (shadowed->first == reg && shadowed->second.registerCount == globalId)
+                {
+                    mShadowed.erase(shadowed);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        size_t GetSize() const
+        {
+            return mLocations.size();
+        }
+
+        void Clear()
+        {
+            mLocations.clear();
+            mShadowed.clear();
+        }
+
+    private:
+
+        std::vector< const void * > mLocations;
+        std::vector< std::pair< const void *, RegisterInfo > > mShadowed;
+    };
+}
+
+#endif
@@ -28,6 +28,7 @@
 #define __BSPLIB_REGISTERMAPTYPE_H__
 
 #include "bsp/threadRegisterVector.h"
+#include "bsp/threadRegisterHash.h"
 #include "bsp/threadRegisterMap.h"
 
 #ifndef BSP_REGISTERMAP_TYPE
@@ -28,27 +28,40 @@
 #define __BSPLIB_REQUESTVECTOR_H__
 
 #include "bsp/requests.h"
+#include "bsp/bufferPolicy.h"
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 #include <map>
 
 namespace BSPInternal
 {
+    /**
+     * A queue of requests that is cleared by resetting its cursor, so the memory of the requests can be reused. The
+     * queue starts on its own cache line, since queues between different pairs of processors are stored next to
+     * each other, while they are written by different threads.
+     *
+     * Like the stack allocator, the queue keeps its largest size between supersteps, and only releases its memory on
+     * the next request after the `BufferPolicy` decided so on a clear, so the memory is placed by the writing thread.
+     */
+
     template< typename tRequest >
-    class RequestVector
+    class alignas(BSP_CACHE_LINE_SIZE) RequestVector
     {
     public:
 
         RequestVector()
             : mRequests(10),
               mCursor(0),
-              mSize(10)
+              mSize(10),
+              mMinimum(10),
+              mShrinkTo(0)
         {
         }
 
         /**
-         * Constructor.
+         * Constructor. The queue never shrinks below its initial size.
          *
          * @param   size The number of requests.
          */
@@ -56,7 +69,9 @@ namespace BSPInternal
         RequestVector(size_t size)
             : mRequests(size),
               mCursor(0),
-              mSize(size)
+              mSize(size),
+              mMinimum(size),
+              mShrinkTo(0)
         {
         }
 
@@ -65,6 +80,22 @@ namespace BSPInternal
             return mRequests[index];
         }
 
+        /**
+         * Gets the contiguous storage of the requests, which is invalidated when the queue grows.
+         *
+         * @return The first request.
+         */
+
+        tRequest *Data()
+        {
+            return mRequests.data();
+        }
+
+        const tRequest *Data() const
+        {
+            return mRequests.data();
+        }
+
         tRequest &InitRequest()
         {
             if (mCursor >= mSize)
@@ -75,6 +106,53 @@ namespace BSPInternal
             return mRequests[mCursor++];
         }
 
+        /**
+         * Adds the given amount of contiguous requests to the queue.
+         *
+         * @param   count The number of requests.
+         *
+         * @return The first of the requests, which stays valid until the queue grows again.
+         */
+
+        tRequest &InitRequests(size_t count)
+        {
+            while (mCursor + count > mSize)
+            {
+                Grow();
+            }
+
+            tRequest &first = mRequests[mCursor];
+            mCursor += count;
+
+            return first;
+        }
+
+        /**
+         * Drops the requests from the given index onwards.
+         *
+         * @param   size The number of requests to keep.
+         *
+         * @pre size <= GetSize().
+         */
+
+        void Truncate(size_t size)
+        {
+            mCursor = size;
+        }
+
+        /**
+         * Gets the last request in the queue.
+         *
+         * @pre The queue is not empty.
+         *
+         * @return The last request.
+         */
+
+        tRequest &Back()
+        {
+            return mRequests[mCursor - 1];
+        }
+
         tRequest &operator[](size_t index)
         {
             return mRequests[index];
@@ -90,20 +168,48 @@ namespace BSPInternal
             return mCursor;
         }
 
+        /**
+         * Makes sure the given amount of requests fits in the queue without growing. The reserved capacity is kept
+         * when the queue releases its memory.
+         *
+         * @param   size The number of requests.
+         */
+
         void Reserve(size_t size)
         {
-            if (size > mSize - mCursor)
-            {
-                mRequests.resize(mCursor + size);
-                mSize = mRequests.size();
-            }
+            mMinimum = std::max(mMinimum, mCursor + size);
+            MakeRoom(size);
         }
 
+        /**
+         * Clears the queue, and records how many requests it held.
+         */
+
         void Clear()
         {
+            const size_t shrinkTo = mUsage.Record(mCursor, mRequests.size(), mMinimum);
+
+            if (shrinkTo != 0)
+            {
+                // Makes the next request grow the queue, which releases the memory instead
+                mShrinkTo = shrinkTo;
+                mSize = 0;
+            }
+
             mCursor = 0;
         }
 
+        /**
+         * Gets the amount of requests the queue can hold without growing.
+         *
+         * @return The capacity.
+         */
+
+        size_t Capacity() const
+        {
+            return mRequests.size();
+        }
+
         bool Empty() const
         {
             return mCursor == 0;
@@ -152,7 +258,7 @@ namespace BSPInternal
         template< typename tIterator >
         void Append(tIterator begin, tIterator end)
         {
-            Reserve(end - begin);
+            MakeRoom(end - begin);
 
             std::copy(begin, end, End());
 
@@ -165,12 +271,292 @@ namespace BSPInternal
 
         size_t mCursor;
         size_t mSize;
+        /// The capacity the queue never shrinks below
+        size_t mMinimum;
+        /// The capacity the memory is released to on the next request, or 0
+        size_t mShrinkTo;
+        /// The usage of the queue over the supersteps
+        BufferUsage mUsage;
+
+        void MakeRoom(size_t size)
+        {
+            if (mShrinkTo != 0)
+            {
+                mShrinkTo = std::max(mShrinkTo, size);
+                Release();
+            }
+
+            if (size > mSize - mCursor)
+            {
+                mRequests.resize(mCursor + size);
+                mSize = mRequests.size();
+            }
+        }
 
         void Grow()
         {
+            if (mShrinkTo != 0)
+            {
+                Release();
+                return;
+            }
+
             mRequests.resize(static_cast<size_t>(mSize * 1.6f) + 1);
             mSize = mRequests.size();
         }
+
+        /**
+         * Releases the memory of the queue down to the capacity decided on the last clear. The queue is empty, since
+         * no request has been made since.
+         */
+
+        void Release()
+        {
+            std::vector< tRequest >(mShrinkTo).swap(mRequests);
+            mSize = mShrinkTo;
+            mShrinkTo = 0;
+        }
+    };
+
+    /**
+     * A queue of puts. A put may take more than one record, so the queue remembers where its last put starts, to
+     * merge the next put into it, and counts the puts themselves. The extension records and inline payloads that span
+     * several records are accessed here by the index of their put, from the contiguous storage of the queue, rather
+     * than through the requests themselves.
+     */
+
+    class PutRequestVector
+        : public RequestVector< PutRequest >
+    {
+    public:
+
+        PutRequestVector()
+            : mLast(0),
+              mPuts(0)
+        {
+        }
+
+        /**
+         * Adds a put that takes the given amount of records.
+         *
+         * @param   records The number of records.
+         *
+         * @return The first record of the put.
+         */
+
+        PutRequest &InitPut(size_t records)
+        {
+            mLast = GetSize();
+            ++mPuts;
+
+            return InitRequests(records);
+        }
+
+        /**
+         * Adds a buffered put, with an extension record when its location does not fit in the request.
+         *
+         * @param   globalId    The global ID of the destination register.
+         * @param   offset      The offset in the destination register.
+         * @param   location    The location of the payload in the put buffer.
+         * @param   size        The size of the payload in bytes.
+         */
+
+        void InitBuffered(uint32_t globalId, uint32_t offset, uint64_t location, uint32_t size)
+        {
+            InitPut(PutRequest::BufferedRecords(location)).offset = offset;
+            SetBuffered(mLast, globalId, location, size);
+        }
+
+        /**
+         * Adds an inline put of a size known at compile time, of which the payload continues in the records after
+         * the request.
+         *
+         * @tparam  tSize The size of the payload in bytes, at most `PutRequest::InlineCapacity`.
+         *
+         * @param   globalId    The global ID of the destination register.
+         * @param   offset      The offset in the destination register.
+         * @param   payload     The payload.
+         */
+
+        template< size_t tSize >
+        void InitInline(uint32_t globalId, uint32_t offset, const char *payload)
+        {
+            static_assert(tSize <= PutRequest::InlineCapacity, "The payload fits in the queue");
+
+            PutRequest &request = InitPut(PutRequest::InlineRecords(tSize));
+            request.offset = offset;
+            request.SetInline(globalId, tSize);
+            memcpy(Payload(mLast), payload, tSize);
+        }
+
+        /**
+         * Describes the put at the given index as a buffered put. A wide put keeps its location in the extension
+         * record after it.
+         *
+         * @param   index       The index of the put.
+         * @param   globalId    The global ID of the destination register.
+         * @param   location    The location of the payload in the put buffer.
+         * @param   size        The size of the payload in bytes.
+         *
+         * @pre The put takes at least PutRequest::BufferedRecords(location) records.
+         */
+
+        void SetBuffered(size_t index, uint32_t globalId, uint64_t location, uint32_t size)
+        {
+            PutRequest &request = GetRequest(index);
+            request.size = size;
+
+            if (PutRequest::BufferedRecords(location) == 1)
+            {
+                request.globalId = globalId;
+                request.bufferLocation = static_cast<uint32_t>(location);
+            }
+            else
+            {
+                request.globalId = (static_cast<uint32_t>(PutRequest::WideKind) << PutRequest::IdBits) | globalId;
+                request.bufferLocation = 0;
+
+                PutRequest &extension = GetRequest(index + 1);
+                extension.bufferLocation = static_cast<uint32_t>(location);
+                extension.size = static_cast<uint32_t>(location >> 32);
+            }
+        }
+
+        /**
+         * Gets the location of the payload of the buffered put at the given index in the put buffer.
+         *
+         * @param   index The index of the put.
+         *
+         * @return The buffer location.
+         */
+
+        uint64_t BufferLocation(size_t index) const
+        {
+            const PutRequest &request = (*this)[index];
+
+            if (request.IsWide())
+            {
+                const PutRequest &extension = (*this)[index + 1];
+                return (static_cast<uint64_t>(extension.size) << 32) | extension.bufferLocation;
+            }
+
+            return request.bufferLocation;
+        }
+
+        /**
+         * Gets the payload of the inline put at the given index, which starts at the buffer location of the request,
+         * and continues into the records after it when it is larger than 8 bytes.
+         *
+         * @param   index The index of the put.
+         *
+         * @return The payload, which is invalidated when the queue grows.
+         */
+
+        char *Payload(size_t index)
+        {
+            return reinterpret_cast<char *>(Data() + index) + offsetof(PutRequest, bufferLocation);
+        }
+
+        const char *Payload(size_t index) const
+        {
+            return reinterpret_cast<const char *>(Data() + index) + offsetof(PutRequest, bufferLocation);
+        }
+
+        /**
+         * Copies the payload of the inline put at the given index to the given destination, with a move of its fixed
+         * size, since a copy of a size only known at run time is much slower for these tiny payloads.
+         *
+         * @param   index       The index of the put.
+         * @param [in,out]  dst The destination.
+         */
+
+        void CopyInline(size_t index, char *dst) const
+        {
+            const char *payload = Payload(index);
+            const uint32_t size = (*this)[index].Kind();
+
+            switch (size)
+            {
+            case 32:
+                memcpy(dst, payload, 32);
+                break;
+
+            case 24:
+                memcpy(dst, payload, 24);
+                break;
+
+            case 16:
+                memcpy(dst, payload, 16);
+                break;
+
+            case 12:
+                memcpy(dst, payload, 12);
+                break;
+
+            case 8:
+                memcpy(dst, payload, 8);
+                break;
+
+            case 4:
+                memcpy(dst, payload, 4);
+                break;
+
+            case 2:
+                memcpy(dst, payload, 2);
+                break;
+
+            case 1:
+                memcpy(dst, payload, 1);
+                break;
+
+            default:
+                memcpy(dst, payload, size);
+                break;
+            }
+        }
+
+        /**
+         * Gets the index of the first record of the last put in the queue.
+         *
+         * @pre The queue is not empty.
+         *
+         * @return The index of the last put.
+         */
+
+        size_t LastPut() const
+        {
+            return mLast;
+        }
+
+        /**
+         * Drops the records of the last put beyond the given amount.
+         *
+         * @param   records The number of records the last put keeps.
+         */
+
+        void TruncateLastPut(size_t records)
+        {
+            Truncate(mLast + records);
+        }
+
+        size_t PutCount() const
+        {
+            return mPuts;
+        }
+
+        void Clear()
+        {
+            RequestVector< PutRequest >::Clear();
+            mLast = 0;
+            mPuts = 0;
+        }
+
+    private:
+
+        /// The index of the first record of the last put
+        size_t mLast;
+        /// The number of puts in the queue
+        size_t mPuts;
     };
 }
 
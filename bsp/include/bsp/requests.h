@@ -30,6 +30,8 @@
 #include "bsp/stackAllocator.h"
 
 #include <stdint.h>
+#include <cstddef>
+#include <limits>
 
 namespace BSPInternal
 {
@@ -39,10 +41,111 @@ namespace BSPInternal
         uint32_t registerCount;
     };
 
+    /**
+     * A buffered put. The offset is 32 bits, since registers are at most 4 GiB, and so is the buffer location of
+     * every put in the first 4 GiB of the put buffer, so four requests fit in a cache line. A put further in the
+     * buffer is marked wide, and is followed in its queue by an extension record that holds its full buffer location.
+     *
+     * Puts of at most `InlineCapacity` bytes store their payload in the queue, and mark their size in the top bits of
+     * the global ID. The first 8 bytes take the place of the buffer location and size, and the rest is stored in
+     * whole records after the request, so a 16 byte value takes two records and a 32 byte value three. Global IDs
+     * therefore stay below `IdMask`.
+     *
+     * A request only describes its own record; the extension records and the payloads that continue after it are
+     * accessed through its `PutRequestVector`.
+     */
+
     struct PutRequest
     {
-        StackAllocator::StackLocation bufferLocation;
-        //const void *destination;
+        enum : uint32_t
+        {
+            InlineCapacity = 32,
+            IdBits = 24,
+            IdMask = (1u << IdBits) - 1,
+            /// The kind of a put that is followed by an extension record
+            WideKind = 0xFF
+        };
+
+        uint32_t offset;
+        uint32_t globalId;
+        uint32_t bufferLocation;
+        uint32_t size;
+
+        /**
+         * Gets the number of records an inline put of the given size takes in its queue.
+         *
+         * @param   inlineSize The size of the payload in bytes.
+         *
+         * @return The number of records.
+         */
+
+        static constexpr uint32_t InlineRecords(uint32_t inlineSize)
+        {
+            return inlineSize <= 8 ? 1 : 1 + (inlineSize - 8 + 15) / 16;
+        }
+
+        /**
+         * Gets the number of records a buffered put at the given buffer location takes in its queue.
+         *
+         * @param   location The location of the payload in the put buffer.
+         *
+         * @return The number of records.
+         */
+
+        static uint32_t BufferedRecords(uint64_t location)
+        {
+            return location > std::numeric_limits< uint32_t >::max() ? 2 : 1;
+        }
+
+        uint32_t Kind() const
+        {
+            return globalId >> IdBits;
+        }
+
+        bool IsInline() const
+        {
+            return Kind() != 0 && Kind() != WideKind;
+        }
+
+        bool IsWide() const
+        {
+            return Kind() == WideKind;
+        }
+
+        uint32_t GlobalId() const
+        {
+            return globalId & IdMask;
+        }
+
+        uint32_t Size() const
+        {
+            return IsInline() ? Kind() : size;
+        }
+
+        /**
+         * Gets the number of records the put takes in its queue, including this one.
+         *
+         * @return The number of records.
+         */
+
+        uint32_t Records() const
+        {
+            return IsWide() ? 2 : IsInline() ? InlineRecords(Kind()) : 1;
+        }
+
+        void SetInline(uint32_t id, uint32_t inlineSize)
+        {
+            globalId = (inlineSize << IdBits) | id;
+        }
+    };
+
+    static_assert(sizeof(PutRequest) == 16 && offsetof(PutRequest, bufferLocation) == 8 &&
+                  offsetof(PutRequest, size) == 12,
+                  "The inline payload of a put spans its buffer location and size, and continues in whole records");
+
+    struct HPPutRequest
+    {
+        const void *source;
         ptrdiff_t offset;
         uint32_t globalId;
         uint32_t size;
@@ -51,8 +154,8 @@ namespace BSPInternal
     struct GetRequest
     {
         const void *destination;
-        uint32_t globalId;
         ptrdiff_t offset;
+        uint32_t globalId;
         uint32_t size;
     };
 
@@ -63,21 +166,16 @@ namespace BSPInternal
         uint32_t size;
     };
 
+    /**
+     * A message. The tag is stored directly after the payload in the send buffer, and since all messages of a
+     * superstep have the same tag size, only the payload is described. The send buffer to a processor holds at most
+     * 4 GiB in a superstep.
+     */
+
     struct SendRequest
     {
-        StackAllocator::StackLocation bufferLocation;
+        uint32_t bufferLocation;
         uint32_t bufferSize;
-
-        StackAllocator::StackLocation tagLocation;
-        uint32_t tagSize;
-
-        void From(const SendRequest &request)
-        {
-            bufferLocation = request.bufferLocation;
-            bufferSize = request.bufferSize;
-            tagLocation = request.tagLocation;
-            tagSize = request.tagSize;
-        }
     };
 
     struct PushRequest
@@ -86,9 +184,14 @@ namespace BSPInternal
         RegisterInfo registerInfo;
     };
 
+    /**
+     * A pop. The global ID of the popped registration is resolved during the sync.
+     */
+
     struct PopRequest
     {
         const void *popRegister;
+        uint32_t globalId;
     };
 
 }
@@ -0,0 +1,281 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_SPLITBARRIER_H__
+#define __BSPLIB_SPLITBARRIER_H__
+
+#ifndef BSP_SPIN_ITERATIONS
+#define BSP_SPIN_ITERATIONS 20000
+#endif
+
+#include "bsp/alignedAllocator.h"
+#include "bsp/bspAbort.h"
+#include "bsp/util.h"
+
+#include <atomic>
+#include <thread>
+
+namespace BSPInternal
+{
+    /**
+     * A split phase barrier, where a thread arrives at the barrier without waiting, and waits for the other threads
+     * to arrive later, so it can do work in between. The waiting thread spins for a while, and then yields its core
+     * to the threads that have not arrived yet.
+     *
+     * Once a generation has been completed, the barrier hands out the delivery of every thread exactly once, so the
+     * threads that already wait can deliver the requests of the threads that are still working.
+     */
+
+    class SplitBarrier
+    {
+    public:
+
+        SplitBarrier()
+            : mCount(0),
+              mSpaces(0),
+              mGeneration(0)
+        {
+            mFlags[0] = 0;
+            mFlags[1] = 0;
+        }
+
+        /**
+         * Sets the size of the barrier, thus the number of threads to wait for on a sync point.
+         *
+         * @param   count Number of threads to wait on.
+         *
+         * @post The amount of threads the barriers waits on equals count.
+         */
+
+        void SetSize(uint32_t count)
+        {
+            mCount = count;
+            mSpaces = count;
+            mGeneration = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
+
+            CacheAlignedVector< Delivery >(count).swap(mDeliveries);
+
+            for (Delivery &delivery : mDeliveries)
+            {
+                delivery.claimed = 0;
+                delivery.completed = 0;
+            }
+        }
+
+        /**
+         * Arrives at the barrier with the given flags, without waiting for the other threads.
+         *
+         * @param   flags The flags this thread arrives with.
+         *
+         * @return The generation to wait for.
+         *
+         * @pre The thread has waited for the generation it arrived at before.
+         */
+
+        uint32_t Arrive(uint32_t flags)
+        {
+            const uint32_t myGeneration = mGeneration;
+
+            if (flags)
+            {
+                mFlags[myGeneration & 1] |= flags;
+            }
+
+            if (!--mSpaces)
+            {
+                mSpaces = mCount;
+                mFlags[(myGeneration + 1) & 1] = 0;
+                ++mGeneration;
+            }
+
+            return myGeneration;
+        }
+
+        /**
+         * Checks whether all threads have arrived in the given generation.
+         *
+         * @param   generation The generation the thread arrived at.
+         *
+         * @return Whether waiting for the generation returns immediately.
+         */
+
+        bool Test(uint32_t generation) const
+        {
+            return mGeneration != generation;
+        }
+
+        /**
+         * Waits for all threads to arrive in the given generation. The flags of a generation are kept until the next
+         * generation has been completed, which cannot happen before every thread has waited for this one.
+         *
+         * @param [in,out]  aborted    Check whether the process should be aborted.
+         * @param           generation The generation the thread arrived at.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t generation)
+        {
+            size_t i = 0;
+
+            while (mGeneration == generation)
+            {
+                if (aborted)
+                {
+                    throw BspAbort("Aborted");
+                }
+
+                if (++i < BSP_SPIN_ITERATIONS)
+                {
+                    BSPUtil::Pause();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            if (aborted)
+            {
+                throw BspAbort("Aborted");
+            }
+
+            return static_cast<uint32_t>(mFlags[generation & 1]);
+        }
+
+        /**
+         * Claims the delivery of the requests to the given thread in the given generation.
+         *
+         * @param   id         The identifier of the receiving thread.
+         * @param   generation The generation the calling thread waited for.
+         *
+         * @return Whether the calling thread claimed the delivery, and thus has to complete it.
+         *
+         * @pre Wait has returned for the generation.
+         */
+
+        bool ClaimDelivery(uint32_t id, uint32_t generation)
+        {
+            // Nobody claims the next generation before every thread waited for this one, so any other value is older
+            const uint32_t claim = generation + 1;
+            uint32_t claimed = mDeliveries[id].claimed;
+
+            while (claimed != claim)
+            {
+                if (mDeliveries[id].claimed.compare_exchange_weak(claimed, claim))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * Marks the claimed delivery to the given thread as completed, which publishes the delivered data.
+         *
+         * @param   id         The identifier of the receiving thread.
+         * @param   generation The generation the delivery was claimed in.
+         */
+
+        void CompleteDelivery(uint32_t id, uint32_t generation)
+        {
+            mDeliveries[id].completed = generation + 1;
+        }
+
+        /**
+         * Waits until the delivery to the given thread has been completed by the thread that claimed it.
+         *
+         * @param [in,out]  aborted    Check whether the process should be aborted.
+         * @param           id         The identifier of the receiving thread.
+         * @param           generation The generation the delivery was claimed in.
+         *
+         * @pre The delivery has been claimed for the generation.
+         */
+
+        void WaitDelivery(const std::atomic_bool &aborted, uint32_t id, uint32_t generation)
+        {
+            const uint32_t claim = generation + 1;
+            size_t i = 0;
+
+            while (mDeliveries[id].completed != claim)
+            {
+                if (aborted)
+                {
+                    throw BspAbort("Aborted");
+                }
+
+                if (++i < BSP_SPIN_ITERATIONS)
+                {
+                    BSPUtil::Pause();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        void NotifyAbort()
+        {
+            ++mGeneration;
+        }
+
+    private:
+
+        /**
+         * The delivery state of a thread, on its own cache line. Both values hold the last generation plus one.
+         */
+
+        struct alignas(BSP_CACHE_LINE_SIZE) Delivery
+        {
+            /// The generation in which the delivery was last claimed
+            std::atomic< uint32_t > claimed;
+
+            /// The generation in which the delivery was last completed
+            std::atomic< uint32_t > completed;
+        };
+
+        /// The amount of threads to wait for in total
+        uint32_t mCount;
+
+        /// The amount of threads that have not arrived yet, written by every arriving thread
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mSpaces;
+
+        /// The combined flags of the current and the previous generation
+        std::atomic_uint_fast32_t mFlags[2];
+
+        /// The current generation, on its own cache line, since the waiting threads spin on it
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mGeneration;
+
+        /// The delivery state of every thread
+        CacheAlignedVector< Delivery > mDeliveries;
+    };
+}
+
+#endif
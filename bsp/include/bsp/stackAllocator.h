@@ -28,19 +28,27 @@
 #define __BSPLIB_STACKALLOCATOR_H__
 
 #include "util.h"
+#include "stackMemory.h"
+#include "bufferPolicy.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cstddef>
-#include <vector>
 
 namespace BSPInternal
 {
     /**
      * A stack allocator implementation, that will allocate memory in contiguous memory on the stack,
-     * optimising cache line efficiency.
+     * optimising cache line efficiency. The allocator starts on its own cache line, so the cursors of buffers that are
+     * stored next to each other, but written by different threads, do not share a cache line. The memory comes
+     * from `tStackMemory`, which can be selected by defining `BSP_STACK_MEMORY_TYPE`.
+     *
+     * The stack keeps its largest size between supersteps, but releases its memory when it has been used sparsely
+     * for a while, as decided by the `BufferPolicy`. Since the stack may be cleared by another thread than the one
+     * writing it, the memory is only released on the next allocation, so it is placed by the writing thread.
      */
 
-    class StackAllocator
+    class alignas(BSP_CACHE_LINE_SIZE) StackAllocator
     {
     public:
 
@@ -51,25 +59,60 @@ namespace BSPInternal
          */
 
         StackAllocator()
-            : mStack(10, '@'),
+            : mStack(10),
               mCursor(0),
-              mSize(10)
+              mLimit(mStack.Capacity()),
+              mMinimum(10),
+              mShrinkTo(0)
         {
         }
 
         /**
-         * Constructor.
+         * Constructor. The stack never shrinks below its initial size.
          *
          * @param   size The size in bytes.
          */
 
         StackAllocator(size_t size)
-            : mStack(size, '@'),
+            : mStack(size),
               mCursor(0),
-              mSize(size)
+              mLimit(mStack.Capacity()),
+              mMinimum(size),
+              mShrinkTo(0)
         {
         }
 
+        /**
+         * Copy constructor, that only copies the used part of the stack.
+         *
+         * @param   other The stack allocator to copy.
+         */
+
+        StackAllocator(const StackAllocator &other)
+            : mStack(other.mStack.Capacity()),
+              mCursor(other.mCursor),
+              mLimit(other.mLimit),
+              mMinimum(other.mMinimum),
+              mShrinkTo(other.mShrinkTo),
+              mUsage(other.mUsage)
+        {
+            memcpy(mStack.Data(), other.mStack.Data(), mCursor);
+        }
+
+        StackAllocator(StackAllocator &&other) = default;
+
+        StackAllocator &operator=(const StackAllocator &other)
+        {
+            if (this != &other)
+            {
+                *this = StackAllocator(other);
+            }
+
+            return *this;
+        }
+
+        StackAllocator &operator=(StackAllocator &&other) = default;
+
         /**
          * Check whether an object of given amount of its in stack.
          *
@@ -80,7 +123,7 @@ namespace BSPInternal
 
         BSP_FORCEINLINE bool FitsInStack(size_t size) const
         {
-            return mCursor + size < mSize;
+            return mCursor + size < mLimit;
         }
 
         /**
@@ -101,7 +144,7 @@ namespace BSPInternal
             }
 
             const StackLocation loc = mCursor;
-            char *buffer = mStack.data() + loc;
+            char *buffer = mStack.Data() + loc;
             memcpy(buffer, content, size);
 
             mCursor += size;
@@ -109,6 +152,33 @@ namespace BSPInternal
             return loc;
         }
 
+        /**
+         * Allocates an object of a size known at compile time on the stack, so it is copied with moves of its fixed
+         * size instead of a copy of a size only known at run time.
+         *
+         * @tparam  tSize The size of the content in bytes.
+         *
+         * @param   content The content to place on the stack.
+         *
+         * @return A StackLocation that refers to the object.
+         */
+
+        template< size_t tSize >
+        BSP_FORCEINLINE StackLocation AllocFixed(const char *content)
+        {
+            if (!FitsInStack(tSize))
+            {
+                Grow(tSize);
+            }
+
+            const StackLocation loc = mCursor;
+            memcpy(mStack.Data() + loc, content, tSize);
+
+            mCursor += tSize;
+
+            return loc;
+        }
+
         /**
          * Extracts this object on the given stack location.
          *
@@ -119,15 +189,62 @@ namespace BSPInternal
 
         inline void Extract(StackLocation location, size_t size, char *dst) const
         {
-            memcpy(dst, mStack.data() + location, size);
+            memcpy(dst, mStack.Data() + location, size);
         }
 
         /**
-         * Clears this object to its blank/initial state.
+         * Gets a pointer to the memory at the given stack location. The pointer is invalidated when the stack grows.
+         *
+         * @param   location The location of the memory.
+         *
+         * @return The memory at the given location.
+         */
+
+        inline const char *Data(StackLocation location) const
+        {
+            return mStack.Data() + location;
+        }
+
+        /**
+         * Makes sure the given amount of bytes fits in the stack without growing. The reserved capacity is kept when
+         * the stack releases its memory.
+         *
+         * @param   size The size in bytes.
+         */
+
+        inline void Reserve(size_t size)
+        {
+            const size_t capacity = static_cast<size_t>(mCursor) + size + 1;
+            mMinimum = std::max(mMinimum, capacity);
+
+            if (mShrinkTo != 0)
+            {
+                mShrinkTo = std::max(mShrinkTo, capacity);
+                Release();
+            }
+
+            if (!FitsInStack(size))
+            {
+                mStack.Grow(capacity, mCursor);
+                mLimit = mStack.Capacity();
+            }
+        }
+
+        /**
+         * Clears this object to its blank/initial state, and records how much of the stack was used.
          */
 
         inline void Clear()
         {
+            const size_t shrinkTo = mUsage.Record(static_cast<size_t>(mCursor), mStack.Capacity(), mMinimum);
+
+            if (shrinkTo != 0)
+            {
+                // Fail the next fit check, so the writer releases the memory on its next allocation
+                mShrinkTo = shrinkTo;
+                mLimit = 0;
+            }
+
             mCursor = 0;
         }
 
@@ -139,7 +256,7 @@ namespace BSPInternal
 
         inline void Merge(StackAllocator &sa)
         {
-            Alloc(sa.mCursor, sa.mStack.data());
+            Alloc(sa.mCursor, sa.mStack.Data());
         }
 
         /**
@@ -158,13 +275,31 @@ namespace BSPInternal
             return mCursor == 0;
         }
 
+        /**
+         * Gets the capacity of the stack in bytes.
+         *
+         * @return The capacity.
+         */
+
+        inline size_t Capacity() const
+        {
+            return mStack.Capacity();
+        }
+
     private:
 
         /// The stack buffer
-        std::vector< char > mStack;
+        tStackMemory mStack;
         /// The current size of the stack
         StackLocation mCursor;
-        size_t mSize;
+        /// The capacity the next allocation has to fit in, which is 0 when the memory should be released
+        size_t mLimit;
+        /// The capacity the stack never shrinks below
+        size_t mMinimum;
+        /// The capacity the memory is released to on the next allocation, or 0
+        size_t mShrinkTo;
+        /// The usage of the stack over the supersteps
+        BufferUsage mUsage;
 
         /**
          * Grows the stack with a rate of phi, which is mathematically the most efficient
@@ -175,8 +310,30 @@ namespace BSPInternal
 
         BSP_FORCEINLINE void Grow(size_t size)
         {
-            mStack.resize(static_cast<size_t>(mSize * 1.6f) + size, '~');
-            mSize = mStack.size();
+            if (mShrinkTo != 0)
+            {
+                Release();
+
+                if (FitsInStack(size))
+                {
+                    return;
+                }
+            }
+
+            mStack.Grow(static_cast<size_t>(mStack.Capacity() * 1.6f) + size, mCursor);
+            mLimit = mStack.Capacity();
+        }
+
+        /**
+         * Releases the memory of the stack down to the capacity decided on the last clear. The stack is empty, since
+         * nothing has been allocated since.
+         */
+
+        void Release()
+        {
+            mStack.Shrink(mShrinkTo);
+            mShrinkTo = 0;
+            mLimit = mStack.Capacity();
         }
     };
 }
@@ -0,0 +1,325 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_STACKMEMORY_H__
+#define __BSPLIB_STACKMEMORY_H__
+
+#include <cstring>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace BSPInternal
+{
+    /**
+     * The memory of a stack allocator, allocated on the heap. The memory is not initialised, and only the used part
+     * is copied when the memory grows.
+     */
+
+    class HeapStackMemory
+    {
+    public:
+
+        explicit HeapStackMemory(size_t capacity)
+            : mData(new char[capacity]),
+              mCapacity(capacity)
+        {
+        }
+
+        HeapStackMemory(HeapStackMemory &&other) noexcept
+            : mData(std::move(other.mData)),
+              mCapacity(other.mCapacity)
+        {
+            other.mCapacity = 0;
+        }
+
+        HeapStackMemory &operator=(HeapStackMemory &&other) noexcept
+        {
+            mData = std::move(other.mData);
+            mCapacity = other.mCapacity;
+            other.mCapacity = 0;
+
+            return *this;
+        }
+
+        char *Data()
+        {
+            return mData.get();
+        }
+
+        const char *Data() const
+        {
+            return mData.get();
+        }
+
+        size_t Capacity() const
+        {
+            return mCapacity;
+        }
+
+        /**
+         * Grows the memory to the given capacity.
+         *
+         * @param   capacity The new capacity in bytes.
+         * @param   used     The amount of bytes in use, that are kept.
+         */
+
+        void Grow(size_t capacity, size_t used)
+        {
+            std::unique_ptr< char[] > data(new char[capacity]);
+            memcpy(data.get(), mData.get(), used);
+
+            mData.swap(data);
+            mCapacity = capacity;
+        }
+
+        /**
+         * Shrinks the memory to the given capacity, discarding its contents.
+         *
+         * @param   capacity The new capacity in bytes.
+         */
+
+        void Shrink(size_t capacity)
+        {
+            mData.reset(new char[capacity]);
+            mCapacity = capacity;
+        }
+
+    private:
+
+        std::unique_ptr< char[] > mData;
+        size_t mCapacity;
+    };
+
+#if defined(__linux__)
+
+    /**
+     * The memory of a stack allocator, mapped directly from the kernel. The pages are only committed when they are
+     * first written, and the memory grows by remapping the pages, so the contents are never copied.
+     *
+     * Defining `BSP_STACK_HUGE_PAGES` asks for transparent huge pages, and defining `BSP_STACK_EXPLICIT_HUGE_PAGES`
+     * maps the memory from the reserved huge pages when possible. Since explicit huge pages cannot be remapped, their
+     * contents are copied when the memory grows.
+     */
+
+    class MappedStackMemory
+    {
+    public:
+
+        explicit MappedStackMemory(size_t capacity)
+            : mData(nullptr),
+              mCapacity(0),
+              mHugeTlb(false)
+        {
+            Map(capacity);
+        }
+
+        MappedStackMemory(MappedStackMemory &&other) noexcept
+            : mData(other.mData),
+              mCapacity(other.mCapacity),
+              mHugeTlb(other.mHugeTlb)
+        {
+            other.mData = nullptr;
+            other.mCapacity = 0;
+        }
+
+        MappedStackMemory &operator=(MappedStackMemory &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Unmap();
+
+                mData = other.mData;
+                mCapacity = other.mCapacity;
+                mHugeTlb = other.mHugeTlb;
+
+                other.mData = nullptr;
+                other.mCapacity = 0;
+            }
+
+            return *this;
+        }
+
+        MappedStackMemory(const MappedStackMemory &) = delete;
+        MappedStackMemory &operator=(const MappedStackMemory &) = delete;
+
+        ~MappedStackMemory()
+        {
+            Unmap();
+        }
+
+        char *Data()
+        {
+            return mData;
+        }
+
+        const char *Data() const
+        {
+            return mData;
+        }
+
+        size_t Capacity() const
+        {
+            return mCapacity;
+        }
+
+        /**
+         * Grows the memory to the given capacity.
+         *
+         * @param   capacity The new capacity in bytes.
+         * @param   used     The amount of bytes in use, that are kept.
+         */
+
+        void Grow(size_t capacity, size_t used)
+        {
+            if (mHugeTlb)
+            {
+                MappedStackMemory grown(capacity);
+                memcpy(grown.mData, mData, used);
+                *this = std::move(grown);
+                return;
+            }
+
+            capacity = RoundUp(capacity, PageSize());
+            void *data = mremap(mData, mCapacity, capacity, MREMAP_MAYMOVE);
+
+            if (data == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+
+            mData = static_cast<char *>(data);
+            mCapacity = capacity;
+            Advise();
+        }
+
+        /**
+         * Shrinks the memory to the given capacity, discarding its contents. The pages past the new capacity are
+         * returned to the kernel.
+         *
+         * @param   capacity The new capacity in bytes.
+         */
+
+        void Shrink(size_t capacity)
+        {
+            if (mHugeTlb)
+            {
+                *this = MappedStackMemory(capacity);
+                return;
+            }
+
+            capacity = RoundUp(capacity ? capacity : 1, PageSize());
+
+            if (capacity < mCapacity)
+            {
+                munmap(mData + capacity, mCapacity - capacity);
+                mCapacity = capacity;
+            }
+        }
+
+    private:
+
+        char *mData;
+        size_t mCapacity;
+        bool mHugeTlb;
+
+        static size_t PageSize()
+        {
+            static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return pageSize;
+        }
+
+        static size_t RoundUp(size_t size, size_t multiple)
+        {
+            return (size + multiple - 1) / multiple * multiple;
+        }
+
+        void Map(size_t capacity)
+        {
+            void *data = MAP_FAILED;
+
+#if defined(BSP_STACK_EXPLICIT_HUGE_PAGES) && defined(MAP_HUGETLB)
+            const size_t hugeCapacity = RoundUp(capacity, size_t(2) << 20);
+            data = mmap(nullptr, hugeCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if (data != MAP_FAILED)
+            {
+                mData = static_cast<char *>(data);
+                mCapacity = hugeCapacity;
+                mHugeTlb = true;
+                return;
+            }
+
+#endif
+
+            capacity = RoundUp(capacity ? capacity : 1, PageSize());
+            data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+            if (data == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+
+            mData = static_cast<char *>(data);
+            mCapacity = capacity;
+            mHugeTlb = false;
+            Advise();
+        }
+
+        void Unmap()
+        {
+            if (mData)
+            {
+                munmap(mData, mCapacity);
+                mData = nullptr;
+                mCapacity = 0;
+            }
+        }
+
+        void Advise()
+        {
+#if defined(BSP_STACK_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+            madvise(mData, mCapacity, MADV_HUGEPAGE);
+#endif
+        }
+    };
+
+#endif
+}
+
+#ifndef BSP_STACK_MEMORY_TYPE
+typedef BSPInternal::HeapStackMemory tStackMemory;
+#else
+typedef BSP_STACK_MEMORY_TYPE tStackMemory;
+#endif
+
+#endif
@@ -0,0 +1,447 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_THREADPLACEMENT_H__
+#define __BSPLIB_THREADPLACEMENT_H__
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#endif // _WIN32
+
+namespace BSPInternal
+{
+    /**
+     * The policies to place the processors on the CPUs the process is allowed to run on.
+     */
+
+    enum class Placement
+    {
+        /// Do not pin the threads
+        None,
+        /// Fill the hardware threads of a core first, then the cores of a socket
+        Compact,
+        /// Spread the processors over the sockets first, then over the cores of a socket
+        Scatter,
+        /// Use the first hardware thread of every core, before using the siblings
+        OnePerCore,
+        /// Use the given list of CPUs
+        Explicit
+    };
+
+    /**
+     * The topology of a single CPU, as the operating system numbers them.
+     */
+
+    struct CpuInfo
+    {
+        uint32_t cpu;
+        uint32_t package;
+        uint32_t core;
+    };
+
+    /**
+     * Places the processors on the CPUs, following the topology and the allowed CPU set of the process. The policy
+     * can be set through the API, or else through the `BSP_PLACEMENT` environment variable, which is either `none`,
+     * `compact`, `scatter`, `cores`, or a list of CPUs such as `0,2,4-7`. By default every processor gets its own
+     * core, before the hardware thread siblings are used.
+     */
+
+    class ThreadPlacement
+    {
+    public:
+
+        ThreadPlacement()
+            : mPolicy(Placement::OnePerCore),
+              mConfigured(false),
+              mInitialised(false)
+        {
+        }
+
+        void SetPolicy(Placement policy)
+        {
+            mPolicy = policy;
+            mConfigured = true;
+            mOrder.clear();
+        }
+
+        void SetExplicit(const std::vector< uint32_t > &cpus)
+        {
+            mPolicy = Placement::Explicit;
+            mExplicit = cpus;
+            mConfigured = true;
+            mOrder.clear();
+        }
+
+        /**
+         * Determines the CPU of every processor. The topology and allowed CPU set are read the first time, before
+         * any thread has been pinned, since pinning the main thread narrows its affinity.
+         *
+         * @pre Called from the main thread, before the other processors are started.
+         */
+
+        void Prepare()
+        {
+            if (!mInitialised)
+            {
+                mCpus = ReadTopology();
+                mInitialised = true;
+
+                if (!mConfigured)
+                {
+                    const char *environment = std::getenv("BSP_PLACEMENT");
+
+                    if (environment && !ParsePlacement(environment, mPolicy, mExplicit))
+                    {
+                        fprintf(stderr, "Warning: BSP_PLACEMENT `%s` is not understood, using one processor per core.\n", environment);
+                        mPolicy = Placement::OnePerCore;
+                    }
+                }
+            }
+
+            if (mOrder.empty())
+            {
+                mOrder = Order(mCpus, mPolicy, mExplicit);
+            }
+        }
+
+        /**
+         * Pins the calling thread to the CPU of the given processor.
+         *
+         * @param   pid The processor ID of the calling thread.
+         */
+
+        void Pin(uint32_t pid) const
+        {
+#if defined(__linux__)
+
+            if (mOrder.empty())
+            {
+                return;
+            }
+
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(mOrder[pid % mOrder.size()], &cpuset);
+
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#elif defined(_WIN32)
+
+            if (mPolicy != Placement::None)
+            {
+                SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (pid % std::thread::hardware_concurrency()));
+            }
+
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#else
+            (void)pid;
+#endif
+        }
+
+        /**
+         * Orders the CPUs in which they are assigned to the processors.
+         *
+         * @param   cpus        The allowed CPUs and their topology.
+         * @param   policy      The placement policy.
+         * @param   explicitCpus The CPUs for the explicit policy.
+         *
+         * @return The CPU of every processor, wrapping around when there are more processors. Empty if the threads
+         *         should not be pinned.
+         */
+
+        static std::vector< uint32_t > Order(std::vector< CpuInfo > cpus, Placement policy,
+                                             const std::vector< uint32_t > &explicitCpus)
+        {
+            std::vector< uint32_t > order;
+
+            if (policy == Placement::None)
+            {
+                return order;
+            }
+
+            if (policy == Placement::Explicit)
+            {
+                for (uint32_t cpu : explicitCpus)
+                {
+                    if (std::any_of(cpus.begin(), cpus.end(), [cpu](const CpuInfo & info) { return info.cpu == cpu; }))
+                    {
+                        order.push_back(cpu);
+                    }
+                    else
+                    {
+                        fprintf(stderr, "Warning: CPU %u is not available to this process, and is skipped.\n", cpu);
+                    }
+                }
+
+                return order;
+            }
+
+            // Rank the hardware threads within their core, and the cores within their package
+            std::sort(cpus.begin(), cpus.end(), [](const CpuInfo & a, const CpuInfo & b)
+            {
+                return a.package != b.package ? a.package < b.package : a.core != b.core ? a.core < b.core : a.cpu < b.cpu;
+            });
+
+            std::vector< uint32_t > sibling(cpus.size(), 0);
+            std::vector< uint32_t > coreRank(cpus.size(), 0);
+
+            for (size_t i = 1; i < cpus.size(); ++i)
+            {
+                const bool samePackage = cpus[i].package == cpus[i - 1].package;
+                const bool sameCore = samePackage && cpus[i].core == cpus[i - 1].core;
+                sibling[i] = sameCore ? sibling[i - 1] + 1 : 0;
+                coreRank[i] = sameCore ? coreRank[i - 1] : samePackage ? coreRank[i - 1] + 1 : 0;
+            }
+
+            std::vector< size_t > indices(cpus.size());
+
+            for (size_t i = 0; i < indices.size(); ++i)
+            {
+                indices[i] = i;
+            }
+
+            if (policy == Placement::OnePerCore)
+            {
+                std::stable_sort(indices.begin(), indices.end(), [&sibling](size_t a, size_t b)
+                {
+                    return sibling[a] < sibling[b];
+                });
+            }
+            else if (policy == Placement::Scatter)
+            {
+                std::stable_sort(indices.begin(), indices.end(), [&sibling, &coreRank](size_t a, size_t b)
+                {
+                    return sibling[a] != sibling[b] ? sibling[a] < sibling[b] : coreRank[a] < coreRank[b];
+                });
+            }
+
+            for (size_t index : indices)
+            {
+                order.push_back(cpus[index].cpu);
+            }
+
+            return order;
+        }
+
+        /**
+         * Parses a placement description.
+         *
+         * @param           description     The description, `none`, `compact`, `scatter`, `cores` or a CPU list,
+         *                                  of CPUs and ranges of CPUs below the size of a CPU set.
+         * @param [out]     policy          The parsed policy.
+         * @param [out]     explicitCpus    The CPUs in the list, for the explicit policy.
+         *
+         * @return true if the description is valid.
+         */
+
+        static bool ParsePlacement(const std::string &description, Placement &policy, std::vector< uint32_t > &explicitCpus)
+        {
+            if (description == "none")
+            {
+                policy = Placement::None;
+            }
+            else if (description == "compact")
+            {
+                policy = Placement::Compact;
+            }
+            else if (description == "scatter")
+            {
+                policy = Placement::Scatter;
+            }
+            else if (description == "cores")
+            {
+                policy = Placement::OnePerCore;
+            }
+            else
+            {
+                std::vector< uint32_t > cpus;
+                size_t position = 0;
+
+                // Every element between the commas is parsed, so an empty element is rejected as well
+                do
+                {
+                    size_t end = description.find(',', position);
+                    end = end == std::string::npos ? description.size() : end;
+
+                    uint32_t first = 0;
+                    uint32_t last = 0;
+                    const std::string range = description.substr(position, end - position);
+                    const size_t dash = range.find('-');
+
+                    if (dash == std::string::npos)
+                    {
+                        if (!ParseCpu(range, first))
+                        {
+                            return false;
+                        }
+
+                        cpus.push_back(first);
+                    }
+                    else if (ParseCpu(range.substr(0, dash), first) && ParseCpu(range.substr(dash + 1), last) &&
+                             first <= last)
+                    {
+                        // Both bounds are below msMaxCpus, so the range is small and the counter cannot wrap
+                        for (uint32_t cpu = first; cpu <= last; ++cpu)
+                        {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                    else
+                    {
+                        return false;
+                    }
+
+                    position = end + 1;
+                }
+                while (position <= description.size());
+
+                if (cpus.empty())
+                {
+                    return false;
+                }
+
+                policy = Placement::Explicit;
+                explicitCpus = cpus;
+            }
+
+            return true;
+        }
+
+    private:
+
+#if defined(__linux__)
+        /// The CPUs beyond the size of a CPU set cannot be placed on
+        static constexpr uint32_t msMaxCpus = CPU_SETSIZE;
+#else
+        static constexpr uint32_t msMaxCpus = 1024;
+#endif
+
+        Placement mPolicy;
+        bool mConfigured;
+        bool mInitialised;
+
+        std::vector< uint32_t > mExplicit;
+        std::vector< CpuInfo > mCpus;
+        std::vector< uint32_t > mOrder;
+
+        /**
+         * Parses a CPU number, which consists of decimal digits only, and is below msMaxCpus.
+         *
+         * @param   text     The text to parse, which has to be consumed entirely.
+         * @param [out] cpu  The CPU number.
+         *
+         * @return true if the text is a valid CPU number.
+         */
+
+        static bool ParseCpu(const std::string &text, uint32_t &cpu)
+        {
+            if (text.empty())
+            {
+                return false;
+            }
+
+            cpu = 0;
+
+            for (char digit : text)
+            {
+                if (digit < '0' || digit > '9')
+                {
+                    return false;
+                }
+
+                cpu = cpu * 10 + static_cast<uint32_t>(digit - '0');
+
+                // Checked per digit, so long numbers cannot overflow
+                if (cpu >= msMaxCpus)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        static std::vector< CpuInfo > ReadTopology()
+        {
+            std::vector< CpuInfo > cpus;
+
+#if defined(__linux__)
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+
+            if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0)
+            {
+                return cpus;
+            }
+
+            for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &allowed))
+                {
+                    const std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+
+                    CpuInfo info;
+                    info.cpu = cpu;
+                    info.package = ReadTopologyValue(topology + "physical_package_id", 0);
+                    info.core = ReadTopologyValue(topology + "core_id", cpu);
+                    cpus.push_back(info);
+                }
+            }
+
+#endif
+            return cpus;
+        }
+
+        static uint32_t ReadTopologyValue(const std::string &path, uint32_t fallback)
+        {
+            std::ifstream file(path);
+            int64_t value = -1;
+
+            if (file >> value && value >= 0)
+            {
+                return static_cast<uint32_t>(value);
+            }
+
+            return fallback;
+        }
+    };
+}
+
+#endif
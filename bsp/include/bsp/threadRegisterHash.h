@@ -0,0 +1,269 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_THREADREGISTERHASH_H__
+#define __BSPLIB_THREADREGISTERHASH_H__
+
+#include "bsp/registerLocations.h"
+#include "bsp/requests.h"
+
+#include <assert.h>
+#include <cstdint>
+#include <vector>
+
+namespace BSPInternal
+{
+    /**
+     * A register map that finds the registers in an open addressing hash table on the register pointer, with linear
+     * probing. Inserting, erasing and looking up a register take constant time, independent of the amount of
+     * registers, which pays off when thousands of registers are pushed.
+     */
+
+    class ThreadRegisterHash
+    {
+    public:
+
+        ThreadRegisterHash()
+            : mSlots(16),
+              mCount(0)
+        {
+        }
+
+        BSP_FORCEINLINE uint32_t LocalToGlobal(const void *reg) const
+        {
+            const size_t index = Find(reg);
+
+#ifndef BSP_SKIP_CHECKS
+            assert(mSlots[index].used);
+#endif
+
+            return mSlots[index].info.registerCount;
+        }
+
+        BSP_FORCEINLINE const void *GlobalToLocal(uint32_t globalId) const
+        {
+            return mLocations.Get(globalId);
+        }
+
+        BSP_FORCEINLINE const void *LookupGlobal(uint32_t globalId) const
+        {
+            return mLocations.Get(globalId);
+        }
+
+        inline void Insert(const void *reg, const BSPInternal::RegisterInfo &registerInfo)
+        {
+            // Keep the load factor below 3/4, so the probe sequences stay short
+            if ((mCount + 1) * 4 > mSlots.size() * 3)
+            {
+                Grow();
+            }
+
+            Slot &slot = mSlots[Find(reg)];
+
+            if (!slot.used)
+            {
+                slot.reg = reg;
+                slot.used = true;
+                ++mCount;
+            }
+            else
+            {
+                mLocations.Shadow(reg, slot.info);
+            }
+
+            slot.info = registerInfo;
+            mLocations.Set(registerInfo.registerCount, reg);
+        }
+
+        /**
+         * Erases the given register.
+         *
+         * @param   reg The register.
+         *
+         * @return The global ID of the register, so it can be reused, or `uint32_t(-1)` if it was not registered.
+         */
+
+        inline uint32_t Erase(const void *reg)
+        {
+            const size_t mask = mSlots.size() - 1;
+            size_t hole = Find(reg);
+
+            if (!mSlots[hole].used)
+            {
+                return (uint32_t)(-1);
+            }
+
+            const uint32_t globalId = mSlots[hole].info.registerCount;
+
+            if (mLocations.RestoreShadowed(reg, mSlots[hole].info))
+            {
+                return globalId;
+            }
+
+            // Shift the following registers in the probe sequence back into the hole, so lookups never have to
+            // skip over deleted slots
+            for (size_t index = (hole + 1) & mask; mSlots[index].used; index = (index + 1) & mask)
+            {
+                const size_t home = Hash(mSlots[index].reg) & mask;
+
+                if (((index - home) & mask) >= ((index - hole) & mask))
+                {
+                    mSlots[hole] = mSlots[index];
+                    hole = index;
+                }
+            }
+
+            mSlots[hole].used = false;
+            --mCount;
+
+            return globalId;
+        }
+
+        /**
+         * Erases the registration of the given register with the given global ID, which need not be the most recent
+         * one, so a processor that pushed padding pops the same registration as the other processors.
+         *
+         * @param   reg         The register.
+         * @param   globalId    The global ID of the registration.
+         *
+         * @return The global ID, or `uint32_t(-1)` if the register has no such registration.
+         */
+
+        inline uint32_t Erase(const void *reg, uint32_t globalId)
+        {
+            const Slot &slot = mSlots[Find(reg)];
+
+            if (!slot.used)
+            {
+                return (uint32_t)(-1);
+            }
+
+            if (slot.info.registerCount == globalId)
+            {
+                return Erase(reg);
+            }
+
+            return mLocations.EraseShadowed(reg, globalId) ? globalId : (uint32_t)(-1);
+        }
+
+        size_t GetSize() const
+        {
+            return mLocations.GetSize();
+        }
+
+        /**
+         * Removes all registers, but keeps the memory for reuse.
+         */
+
+        inline void Clear()
+        {
+            for (Slot &slot : mSlots)
+            {
+                slot.used = false;
+            }
+
+            mCount = 0;
+            mLocations.Clear();
+        }
+
+    private:
+
+        struct Slot
+        {
+            Slot()
+                : reg(nullptr),
+                  info(),
+                  used(false)
+            {
+            }
+
+            const void *reg;
+            RegisterInfo info;
+            bool used;
+        };
+
+        std::vector< Slot > mSlots;
+        size_t mCount;
+
+        RegisterLocations mLocations;
+
+        static BSP_FORCEINLINE size_t Hash(const void *reg)
+        {
+            // The finaliser of MurmurHash3, since the low bits of pointers are mostly equal
+            uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(reg));
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            return static_cast<size_t>(hash);
+        }
+
+        /**
+         * Finds the slot of the given register, or the empty slot where it should be inserted.
+         *
+         * @param   reg The register.
+         *
+         * @return The index of the slot.
+         */
+
+        BSP_FORCEINLINE size_t Find(const void *reg) const
+        {
+            const size_t mask = mSlots.size() - 1;
+            size_t index = Hash(reg) & mask;
+
+            while (mSlots[index].used && mSlots[index].reg != reg)
+            {
+                index = (index + 1) & mask;
+            }
+
+            return index;
+        }
+
+        void Grow()
+        {
+            std::vector< Slot > slots(mSlots.size() * 2);
+            mSlots.swap(slots);
+
+            const size_t mask = mSlots.size() - 1;
+
+            for (const Slot &slot : slots)
+            {
+                if (slot.used)
+                {
+                    size_t index = Hash(slot.reg) & mask;
+
+                    while (mSlots[index].used)
+                    {
+                        index = (index + 1) & mask;
+                    }
+
+                    mSlots[index] = slot;
+                }
+            }
+        }
+    };
+}
+
+#endif
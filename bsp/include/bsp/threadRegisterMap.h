@@ -27,6 +27,7 @@
 #ifndef __BSPLIB_THREADREGISTERMAP_H__
 #define __BSPLIB_THREADREGISTERMAP_H__
 
+#include "bsp/registerLocations.h"
 #include "bsp/requests.h"
 
 #include <vector>
@@ -45,25 +46,100 @@ namespace BSPInternal
 
         inline const void *GlobalToLocal(uint32_t globalId)
         {
-            return mThreadRegisterLocations[globalId];
+            return mLocations.Get(globalId);
+        }
+
+        inline const void *LookupGlobal(uint32_t globalId) const
+        {
+            return mLocations.Get(globalId);
         }
 
         inline void Insert(const void *reg, const BSPInternal::RegisterInfo &registerInfo)
         {
-            mRegisters[reg] = registerInfo;
-            mThreadRegisterLocations.push_back(reg);
+            auto regIt = mRegisters.find(reg);
+
+            if (regIt != mRegisters.end())
+            {
+                mLocations.Shadow(reg, regIt->second);
+                regIt->second = registerInfo;
+            }
+            else
+            {
+                mRegisters.emplace(reg, registerInfo);
+            }
+
+            mLocations.Set(registerInfo.registerCount, reg);
+        }
+
+        /**
+         * Erases the given register.
+         *
+         * @param   reg The register.
+         *
+         * @return The global ID of the register, so it can be reused, or `uint32_t(-1)` if it was not registered.
+         */
+
+        inline uint32_t Erase(const void *reg)
+        {
+            auto regIt = mRegisters.find(reg);
+
+            if (regIt == mRegisters.end())
+            {
+                return (uint32_t)(-1);
+            }
+
+            const uint32_t globalId = regIt->second.registerCount;
+
+            if (!mLocations.RestoreShadowed(reg, regIt->second))
+            {
+                mRegisters.erase(regIt);
+            }
+
+            return globalId;
+        }
+
+        /**
+         * Erases the registration of the given register with the given global ID, which need not be the most recent
+         * one, so a processor that pushed padding pops the same registration as the other processors.
+         *
+         * @param   reg         The register.
+         * @param   globalId    The global ID of the registration.
+         *
+         * @return The global ID, or `uint32_t(-1)` if the register has no such registration.
+         */
+
+        inline uint32_t Erase(const void *reg, uint32_t globalId)
+        {
+            auto regIt = mRegisters.find(reg);
+
+            if (regIt == mRegisters.end())
+            {
+                return (uint32_t)(-1);
+            }
+
+            if (regIt->second.registerCount == globalId)
+            {
+                return Erase(reg);
+            }
+
+            return mLocations.EraseShadowed(reg, globalId) ? globalId : (uint32_t)(-1);
+        }
+
+        size_t GetSize() const
+        {
+            return mLocations.GetSize();
         }
 
-        inline void Erase(const void *reg)
+        inline void Clear()
         {
-            //mThreadRegisterLocations[LocalToGlobal( reg )] = nullptr;
-            mRegisters.erase(reg);
+            mRegisters.clear();
+            mLocations.Clear();
         }
 
     private:
 
         std::map< const void *, RegisterInfo > mRegisters;
-        std::vector< const void * > mThreadRegisterLocations;
+        RegisterLocations mLocations;
     };
 }
 
@@ -27,6 +27,7 @@
 #ifndef __BSPLIB_THREADREGISTERVECTOR_H__
 #define __BSPLIB_THREADREGISTERVECTOR_H__
 
+#include "bsp/registerLocations.h"
 #include "bsp/requests.h"
 
 #include <algorithm>
@@ -48,7 +49,8 @@ namespace BSPInternal
 
         BSP_FORCEINLINE uint32_t LocalToGlobal(const void *reg)
         {
-            if (reg != mRegisterCache)
+            // The cache is empty when the location is invalid, since padding registers the null pointer
+            if (reg != mRegisterCache || mLocationCache == (uint32_t)(-1))
             {
                 auto l = std::lower_bound(mRegisters.begin(), mRegisters.end(), reg);
 
@@ -67,18 +69,35 @@ namespace BSPInternal
             }
 
             mLocationCache = globalId;
-            mRegisterCache = mThreadRegisterLocations[globalId];
+            mRegisterCache = mLocations.Get(globalId);
 
             return mRegisterCache;
         }
 
+        /**
+         * Looks up the local location of a global register without touching the lookup cache, so other processors
+         * can resolve this processor's registers concurrently during a sync.
+         *
+         * @param   globalId The global register identifier.
+         *
+         * @return The local location of the register.
+         */
+
+        BSP_FORCEINLINE const void *LookupGlobal(uint32_t globalId) const
+        {
+            return mLocations.Get(globalId);
+        }
+
         inline void Insert(const void *reg, const BSPInternal::RegisterInfo &registerInfo)
         {
+            // A register that is pushed again gets a new global ID
+            InvalidateCache();
+
             if (mRegisters.empty())
             {
                 mRegisters.push_back(reg);
                 mRegistersInfo.emplace_back(registerInfo);
-                mThreadRegisterLocations.push_back(reg);
+                mLocations.Set(registerInfo.registerCount, reg);
                 return;
             }
 
@@ -86,31 +105,93 @@ namespace BSPInternal
 
             if (l != mRegisters.end() && *l == reg)
             {
+                mLocations.Shadow(reg, mRegistersInfo[l - mRegisters.begin()]);
                 mRegistersInfo[l - mRegisters.begin()] = registerInfo;
-                mThreadRegisterLocations.push_back(reg);
+                mLocations.Set(registerInfo.registerCount, reg);
             }
             else
             {
                 mRegistersInfo.insert(mRegistersInfo.begin() + (l - mRegisters.begin()), registerInfo);
                 mRegisters.insert(l, reg);
-                mThreadRegisterLocations.push_back(reg);
+                mLocations.Set(registerInfo.registerCount, reg);
+            }
+        }
+
+        /**
+         * Erases the given register.
+         *
+         * @param   reg The register.
+         *
+         * @return The global ID of the register, so it can be reused, or `uint32_t(-1)` if it was not registered.
+         */
+
+        inline uint32_t Erase(const void *reg)
+        {
+            InvalidateCache();
+
+            auto regIt = std::lower_bound(mRegisters.begin(), mRegisters.end(), reg);
+
+            if (regIt == mRegisters.end() || *regIt != reg)
+            {
+                return (uint32_t)(-1);
+            }
+
+            auto infoIt = mRegistersInfo.begin() + (regIt - mRegisters.begin());
+            const uint32_t globalId = infoIt->registerCount;
+
+            if (mLocations.RestoreShadowed(reg, *infoIt))
+            {
+                return globalId;
             }
+
+            mRegistersInfo.erase(infoIt);
+            mRegisters.erase(regIt);
+
+            return globalId;
         }
 
-        inline void Erase(const void *reg)
+        /**
+         * Erases the registration of the given register with the given global ID, which need not be the most recent
+         * one, so a processor that pushed padding pops the same registration as the other processors.
+         *
+         * @param   reg         The register.
+         * @param   globalId    The global ID of the registration.
+         *
+         * @return The global ID, or `uint32_t(-1)` if the register has no such registration.
+         */
+
+        inline uint32_t Erase(const void *reg, uint32_t globalId)
         {
-            auto regIt = std::find(mRegisters.begin(), mRegisters.end(), reg);
+            auto regIt = std::lower_bound(mRegisters.begin(), mRegisters.end(), reg);
 
-            if (regIt != mRegisters.end())
+            if (regIt == mRegisters.end() || *regIt != reg)
             {
-                mRegistersInfo.erase(mRegistersInfo.begin() + (regIt - mRegisters.begin()));
-                mRegisters.erase(regIt);
+                return (uint32_t)(-1);
             }
+
+            if (mRegistersInfo[regIt - mRegisters.begin()].registerCount == globalId)
+            {
+                return Erase(reg);
+            }
+
+            return mLocations.EraseShadowed(reg, globalId) ? globalId : (uint32_t)(-1);
         }
 
         size_t GetSize() const
         {
-            return mThreadRegisterLocations.size();
+            return mLocations.GetSize();
+        }
+
+        /**
+         * Removes all registers, but keeps the memory for reuse.
+         */
+
+        inline void Clear()
+        {
+            mRegisters.clear();
+            mRegistersInfo.clear();
+            mLocations.Clear();
+            InvalidateCache();
         }
 
     private:
@@ -118,10 +199,16 @@ namespace BSPInternal
         std::vector< const void * > mRegisters;
         std::vector< RegisterInfo > mRegistersInfo;
 
-        std::vector< const void * > mThreadRegisterLocations;
+        RegisterLocations mLocations;
 
         const void *mRegisterCache;
         uint32_t mLocationCache;
+
+        void InvalidateCache()
+        {
+            mRegisterCache = nullptr;
+            mLocationCache = (uint32_t)(-1);
+        }
     };
 }
 
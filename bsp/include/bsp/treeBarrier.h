@@ -0,0 +1,274 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_TREEBARRIER_H__
+#define __BSPLIB_TREEBARRIER_H__
+
+#ifndef BSP_TREE_BARRIER_FANIN
+#define BSP_TREE_BARRIER_FANIN 4
+#endif
+
+#ifndef BSP_SPIN_ITERATIONS
+#define BSP_SPIN_ITERATIONS 20000
+#endif
+
+#include "bsp/alignedAllocator.h"
+#include "bsp/bspAbort.h"
+#include "bsp/util.h"
+
+#include <atomic>
+#include <thread>
+
+namespace BSPInternal
+{
+    /**
+     * A combining tree barrier. The threads arrive in groups of `BSP_TREE_BARRIER_FANIN` on the leaves of a tree,
+     * and only the last thread to arrive at a node continues to its parent, carrying the combined flags of the
+     * subtree. Every node is on its own cache line, so at most `BSP_TREE_BARRIER_FANIN` threads contend for a line,
+     * instead of all threads contending for the single counter of the central barriers. The thread that completes
+     * the root releases the other threads by advancing the generation.
+     */
+
+    class TreeBarrier
+    {
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param   count Number of threads to wait for.
+         */
+
+        explicit TreeBarrier(uint32_t count) :
+            mGeneration(0),
+            mTickets(0)
+        {
+            SetSize(count);
+        }
+
+        /**
+         * Sets the size of the barrier, thus the number of threads to wait for on a sync point.
+         *
+         * @param   count Number of threads to wait on.
+         *
+         * @post The amount of threads the barriers waits on equals count.
+         */
+
+        void SetSize(uint32_t count)
+        {
+            size_t nodeCount = 0;
+
+            if (count > 0)
+            {
+                uint32_t width = count;
+
+                do
+                {
+                    width = NodesForWidth(width);
+                    nodeCount += width;
+                }
+                while (width > 1);
+            }
+
+            CacheAlignedVector< Node >(nodeCount).swap(mNodes);
+
+            size_t levelStart = 0;
+
+            for (uint32_t width = count; levelStart < nodeCount;)
+            {
+                const uint32_t levelWidth = NodesForWidth(width);
+                const size_t nextLevelStart = levelStart + levelWidth;
+
+                for (uint32_t i = 0; i < levelWidth; ++i)
+                {
+                    Node &node = mNodes[levelStart + i];
+                    const uint32_t children = width - i * BSP_TREE_BARRIER_FANIN;
+                    node.fanIn = children < BSP_TREE_BARRIER_FANIN ? children : BSP_TREE_BARRIER_FANIN;
+                    node.spaces = node.fanIn;
+                    node.flags = 0;
+                    node.parent = levelWidth > 1 ? nextLevelStart + i / BSP_TREE_BARRIER_FANIN : msRoot;
+                }
+
+                levelStart = nextLevelStart;
+                width = levelWidth;
+            }
+
+            mGeneration = 0;
+            mTickets = 0;
+            mFlags[0] = 0;
+            mFlags[1] = 0;
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, however the process can be aborted when `aborted` equals to
+         * true.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        void Wait(const std::atomic_bool &aborted)
+        {
+            Wait(aborted, 0);
+        }
+
+        /**
+         * Waits for all the threads to reach the sync point, and combines the flags every thread arrives with.
+         *
+         * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param           flags   The flags this thread arrives with.
+         * @param           id      The identifier of the waiting thread, which determines its leaf in the tree. When
+         *                          omitted, the thread takes the next free slot of the generation instead.
+         *
+         * @return The flags of all threads combined with a bitwise or.
+         *
+         * @pre if aborted == true, all threads quit computations.
+         * @pre id is unique for all threads in the barrier, and smaller than the size of the barrier, or it is omitted
+         *      by all threads in the generation.
+         *
+         * @post all threads have waited for each other to reach the barrier.
+         */
+
+        uint32_t Wait(const std::atomic_bool &aborted, uint32_t flags, uint32_t id = msAnyId)
+        {
+            const uint32_t myGeneration = mGeneration;
+
+            if (id == msAnyId)
+            {
+                // Every thread arrives once per generation, so the tickets of a generation are unique
+                id = mTickets++;
+            }
+
+            for (size_t current = id / BSP_TREE_BARRIER_FANIN;;)
+            {
+                Node &node = mNodes[current];
+
+                if (flags)
+                {
+                    node.flags |= flags;
+                }
+
+                if (--node.spaces)
+                {
+                    break;
+                }
+
+                // We are the last to arrive at this node, so nobody touches it until the next generation
+                flags = node.flags.exchange(0);
+                node.spaces = node.fanIn;
+
+                if (node.parent == msRoot)
+                {
+                    mTickets = 0;
+                    mFlags[myGeneration & 1] = flags;
+                    ++mGeneration;
+
+                    return flags;
+                }
+
+                current = node.parent;
+            }
+
+            size_t i = 0;
+
+            while (mGeneration == myGeneration)
+            {
+                if (aborted)
+                {
+                    throw BspAbort("Aborted");
+                }
+
+                if (++i < BSP_SPIN_ITERATIONS)
+                {
+                    BSPUtil::Pause();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            if (aborted)
+            {
+                throw BspAbort("Aborted");
+            }
+
+            return mFlags[myGeneration & 1];
+        }
+
+        void NotifyAbort()
+        {
+            ++mGeneration;
+        }
+
+    private:
+
+        /**
+         * A node of the tree, on its own cache line.
+         */
+
+        struct alignas(BSP_CACHE_LINE_SIZE) Node
+        {
+            /// The amount of children that still have to arrive
+            std::atomic_uint_fast32_t spaces;
+
+            /// The combined flags of the children that arrived
+            std::atomic_uint_fast32_t flags;
+
+            /// The amount of children of this node
+            uint32_t fanIn;
+
+            /// The index of the parent node, or msRoot for the root
+            size_t parent;
+        };
+
+        static const size_t msRoot = static_cast<size_t>(-1);
+
+        static const uint32_t msAnyId = static_cast<uint32_t>(-1);
+
+        /// The nodes of the tree, level by level starting at the leaves
+        CacheAlignedVector< Node > mNodes;
+
+        /// The current waiting generation, so we can reuse the barrier
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mGeneration;
+
+        /// The slots handed out to the threads that wait without an identifier, reset when the generation completes
+        alignas(BSP_CACHE_LINE_SIZE) std::atomic_uint_fast32_t mTickets;
+
+        /// The combined flags of the current and the previous generation, written by the thread completing the root
+        uint32_t mFlags[2];
+
+        static uint32_t NodesForWidth(uint32_t width)
+        {
+            return (width + BSP_TREE_BARRIER_FANIN - 1) / BSP_TREE_BARRIER_FANIN;
+        }
+    };
+}
+
+#endif
@@ -51,10 +51,47 @@
 #  endif
 #endif
 
+// Promises the compiler that a pointer does not alias the others, so the loops over it can be vectorised.
+#if !defined(BSP_RESTRICT)
+#  if defined(_MSC_VER)
+#    define BSP_RESTRICT __restrict
+#  elif defined(__GNUC__) && __GNUC__ > 3
+// Clang also defines __GNUC__ (as 4)
+#    define BSP_RESTRICT __restrict__
+#  else
+#    define BSP_RESTRICT
+#  endif
+#endif
+
+// The size of a cache line, data written by different threads is kept this far apart to prevent false sharing.
+#if !defined(BSP_CACHE_LINE_SIZE)
+#  define BSP_CACHE_LINE_SIZE 64
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#  include <intrin.h>
+#endif
+
 #include <chrono>
 
 namespace BSPUtil
 {
+    /**
+     * Hints the processor that we are in a spin loop, which saves power and leaves the execution units to the
+     * hyperthread sibling.
+     */
+
+    BSP_FORCEINLINE void Pause()
+    {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+        _mm_pause();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+        __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+        __asm__ __volatile__("yield");
+#endif
+    }
+
     template< typename tLoopIterator, typename tFunc>
     BSP_FORCEINLINE void SplitFor(tLoopIterator begin, tLoopIterator end, tLoopIterator start, const tFunc &body)
     {
@@ -81,10 +81,15 @@ public:
     {
     }
 
-    void RecordProcessorsData(uint32_t /*pid*/, const std::vector<ProcessorData> &/*processorsData*/)
+    void RecordProcessorsData(uint32_t /*pid*/, const tProcessorsData &/*processorsData*/)
     {
     }
 
+    bool RecordsProcessorsData() const
+    {
+        return false;
+    }
+
     void PlotData()
     {
     }
@@ -0,0 +1,220 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2018 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#ifndef __BSPLIB_WORKERPOOL_H__
+#define __BSPLIB_WORKERPOOL_H__
+
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+namespace BSPInternal
+{
+    /**
+     * A pool of worker threads that park between runs, so a BSP program can be started without creating threads.
+     * Every worker keeps its identifier over its lifetime, so it serves the same processor in every run.
+     */
+
+    class WorkerPool
+    {
+    public:
+
+        WorkerPool()
+            : mGeneration(0),
+              mCount(0),
+              mRunning(0),
+              mStop(false)
+        {
+        }
+
+        ~WorkerPool()
+        {
+            Stop();
+        }
+
+        /**
+         * Runs the body on the given amount of workers, without waiting for them to finish. Workers are started when
+         * the pool is smaller than the requested amount.
+         *
+         * @param   count The amount of workers to run the body on.
+         * @param   body  The body to run, called with the identifier of the worker.
+         *
+         * @pre The previous run has finished.
+         */
+
+        void Run(uint32_t count, const std::function< void(uint32_t) > &body)
+        {
+            std::lock_guard< std::mutex > lock(mMutex);
+
+            for (uint32_t id = static_cast<uint32_t>(mWorkers.size()); id < count; ++id)
+            {
+                mWorkers.emplace_back(&WorkerPool::Work, this, id);
+            }
+
+            mBody = body;
+            mCount = count;
+            mRunning = count;
+            ++mGeneration;
+
+            mDispatch.notify_all();
+        }
+
+        /**
+         * Waits for the workers to finish the current run. An exception that escaped the body of a worker is rethrown.
+         */
+
+        void Wait()
+        {
+            std::unique_lock< std::mutex > lock(mMutex);
+            mDone.wait(lock, [this] { return mRunning == 0; });
+            RethrowException();
+        }
+
+        /**
+         * Waits for the workers to finish the current run, or the timeout to pass.
+         *
+         * @param   timeout The time to wait at most.
+         *
+         * @return true if the workers have finished, false if the timeout passed.
+         */
+
+        bool WaitFor(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock< std::mutex > lock(mMutex);
+            return mDone.wait_for(lock, timeout, [this] { return mRunning == 0; });
+        }
+
+        /**
+         * Stops and joins all workers.
+         *
+         * @pre The current run has finished.
+         */
+
+        void Stop()
+        {
+            {
+                std::lock_guard< std::mutex > lock(mMutex);
+                mStop = true;
+            }
+
+            mDispatch.notify_all();
+
+            for (auto &worker : mWorkers)
+            {
+                worker.join();
+            }
+
+            mWorkers.clear();
+            mStop = false;
+        }
+
+        size_t GetSize() const
+        {
+            return mWorkers.size();
+        }
+
+    private:
+
+        std::vector< std::thread > mWorkers;
+
+        std::mutex mMutex;
+        std::condition_variable mDispatch;
+        std::condition_variable mDone;
+
+        std::function< void(uint32_t) > mBody;
+        std::exception_ptr mException;
+
+        size_t mGeneration;
+        uint32_t mCount;
+        uint32_t mRunning;
+        bool mStop;
+
+        void Work(uint32_t id)
+        {
+            size_t generation = 0;
+            std::unique_lock< std::mutex > lock(mMutex);
+
+            for (;;)
+            {
+                mDispatch.wait(lock, [this, &generation] { return mStop || mGeneration != generation; });
+
+                if (mStop)
+                {
+                    return;
+                }
+
+                generation = mGeneration;
+
+                if (id >= mCount)
+                {
+                    continue;
+                }
+
+                std::function< void(uint32_t) > body = mBody;
+                lock.unlock();
+
+                std::exception_ptr exception;
+
+                try
+                {
+                    body(id);
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+
+                lock.lock();
+
+                if (exception && !mException)
+                {
+                    mException = exception;
+                }
+
+                if (--mRunning == 0)
+                {
+                    mDone.notify_all();
+                }
+            }
+        }
+
+        void RethrowException()
+        {
+            if (mException)
+            {
+                std::exception_ptr exception = mException;
+                mException = nullptr;
+                std::rethrow_exception(exception);
+            }
+        }
+    };
+}
+
+#endif
@@ -93,6 +93,59 @@ void TestBarrier(uint32_t threads, const std::atomic_bool &abort)
     delete[] check;
 }
 
+template< typename tBarrier >
+void TestBarrierFlags(uint32_t threads, uint32_t generations, bool explicitIds = false)
+{
+    std::atomic_bool abort(false);
+    std::vector< std::future< void >> futures;
+    std::vector< uint32_t > combined(threads * generations, 0);
+
+    tBarrier barrier(threads);
+
+    // Only even generations carry flags, so the odd ones check that the flags are reset
+    auto flags = [](uint32_t generation, uint32_t id) -> uint32_t
+    {
+        return generation % 2 == 0 ? 1u << ((generation / 2 + id) % 32) : 0u;
+    };
+
+    // BSP passes the processor id, while the tests of the other barriers let the threads arrive without one
+    auto body = [&barrier, &combined, &abort, &flags, threads, generations, explicitIds](uint32_t id)
+    {
+        for (uint32_t g = 0; g < generations; ++g)
+        {
+            combined[g * threads + id] = explicitIds ? barrier.Wait(abort, flags(g, id), id) :
+                                         barrier.Wait(abort, flags(g, id));
+        }
+    };
+
+    for (uint32_t i = 0; i < threads - 1; ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async, body, i));
+    }
+
+    body(threads - 1);
+
+    for (auto &thread : futures)
+    {
+        thread.wait();
+    }
+
+    for (uint32_t g = 0; g < generations; ++g)
+    {
+        uint32_t expected = 0;
+
+        for (uint32_t id = 0; id < threads; ++id)
+        {
+            expected |= flags(g, id);
+        }
+
+        for (uint32_t id = 0; id < threads; ++id)
+        {
+            EXPECT_EQ(expected, combined[g * threads + id]);
+        }
+    }
+}
+
 /*
 ///  Disabled since spinbarriers are not very cpu friendly
 TEST( P( Barrier ), Simple2 )
@@ -176,6 +229,161 @@ TEST(P(MixedBarrier), Simple32)
     TestBarrier< BSPInternal::CondVarBarrier >(32, std::atomic_bool(false));
 }
 
+TEST(P(CondVarBarrier), Flags1)
+{
+    TestBarrierFlags< BSPInternal::CondVarBarrier >(1, 100);
+}
+
+TEST(P(CondVarBarrier), Flags4)
+{
+    TestBarrierFlags< BSPInternal::CondVarBarrier >(4, 100);
+}
+
+TEST(P(CondVarBarrier), Flags16)
+{
+    TestBarrierFlags< BSPInternal::CondVarBarrier >(16, 100);
+}
+
+TEST(P(MixedBarrier), Flags1)
+{
+    TestBarrierFlags< BSPInternal::MixedBarrier >(1, 100);
+}
+
+TEST(P(MixedBarrier), Flags4)
+{
+    TestBarrierFlags< BSPInternal::MixedBarrier >(4, 100);
+}
+
+TEST(P(MixedBarrier), Flags16)
+{
+    TestBarrierFlags< BSPInternal::MixedBarrier >(16, 100);
+}
+
+TEST(P(TreeBarrier), Simple)
+{
+    TestBarrier< BSPInternal::TreeBarrier >(1, std::atomic_bool(false));
+}
+
+TEST(P(TreeBarrier), Simple2)
+{
+    TestBarrier< BSPInternal::TreeBarrier >(2, std::atomic_bool(false));
+}
+
+TEST(P(TreeBarrier), Simple5)
+{
+    TestBarrier< BSPInternal::TreeBarrier >(5, std::atomic_bool(false));
+}
+
+TEST(P(TreeBarrier), Simple16)
+{
+    TestBarrier< BSPInternal::TreeBarrier >(16, std::atomic_bool(false));
+}
+
+TEST(P(TreeBarrier), Simple33)
+{
+    TestBarrier< BSPInternal::TreeBarrier >(33, std::atomic_bool(false));
+}
+
+TEST(P(TreeBarrier), Flags1)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(1, 100);
+}
+
+TEST(P(TreeBarrier), Flags7)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(7, 100);
+}
+
+TEST(P(TreeBarrier), Flags17)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(17, 100);
+}
+
+TEST(P(TreeBarrier), FlagsIds1)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(1, 100, true);
+}
+
+TEST(P(TreeBarrier), FlagsIds4)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(4, 100, true);
+}
+
+TEST(P(TreeBarrier), FlagsIds7)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(7, 100, true);
+}
+
+TEST(P(TreeBarrier), FlagsIds17)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(17, 100, true);
+}
+
+TEST(P(TreeBarrier), FlagsIds33)
+{
+    TestBarrierFlags< BSPInternal::TreeBarrier >(33, 100, true);
+}
+
+TEST(P(TreeBarrier), Abort2)
+{
+    ASSERT_THROW(TestBarrier< BSPInternal::TreeBarrier >(2, std::atomic_bool(true)), BSPInternal::BspAbort);
+}
+
+TEST(P(TreeBarrier), Abort8)
+{
+    ASSERT_THROW(TestBarrier< BSPInternal::TreeBarrier >(8, std::atomic_bool(true)), BSPInternal::BspAbort);
+}
+
+TEST(P(TreeBarrier), Abort32)
+{
+    ASSERT_THROW(TestBarrier< BSPInternal::TreeBarrier >(32, std::atomic_bool(true)), BSPInternal::BspAbort);
+}
+
+TEST(P(FutexBarrier), Simple)
+{
+    TestBarrier< BSPInternal::FutexBarrier >(1, std::atomic_bool(false));
+}
+
+TEST(P(FutexBarrier), Simple4)
+{
+    TestBarrier< BSPInternal::FutexBarrier >(4, std::atomic_bool(false));
+}
+
+TEST(P(FutexBarrier), Simple32)
+{
+    TestBarrier< BSPInternal::FutexBarrier >(32, std::atomic_bool(false));
+}
+
+TEST(P(FutexBarrier), Flags4)
+{
+    TestBarrierFlags< BSPInternal::FutexBarrier >(4, 100);
+}
+
+TEST(P(FutexBarrier), Flags16)
+{
+    TestBarrierFlags< BSPInternal::FutexBarrier >(16, 100);
+}
+
+TEST(P(FutexBarrier), FlagsIds5)
+{
+    TestBarrierFlags< BSPInternal::FutexBarrier >(5, 100, true);
+}
+
+TEST(P(FutexBarrier), FlagsIds17)
+{
+    TestBarrierFlags< BSPInternal::FutexBarrier >(17, 100, true);
+}
+
+TEST(P(FutexBarrier), Abort2)
+{
+    ASSERT_THROW(TestBarrier< BSPInternal::FutexBarrier >(2, std::atomic_bool(true)), BSPInternal::BspAbort);
+}
+
+TEST(P(FutexBarrier), Abort32)
+{
+    ASSERT_THROW(TestBarrier< BSPInternal::FutexBarrier >(32, std::atomic_bool(true)), BSPInternal::BspAbort);
+}
+
 TEST(P(CondVarBarrier), Abort2)
 {
     ASSERT_THROW(TestBarrier< BSPInternal::CondVarBarrier >(2, std::atomic_bool(true)), BSPInternal::BspAbort);
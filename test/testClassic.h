@@ -173,6 +173,46 @@ void PushPopTest()
     }
 }
 
+template< uint32_t tRounds >
+void PushPopReuseTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+    uint32_t to = (s + 1) % nProc;
+    uint32_t from = (s + nProc - 1) % nProc;
+
+    uint32_t persistent = 0;
+    BSPLib::Classic::Push(&persistent, sizeof(uint32_t));
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tRounds; ++i)
+    {
+        // Temporary registers are pushed and popped every round, so their global IDs are reused
+        std::vector< uint32_t > first(2, 0);
+        std::vector< uint32_t > second(3, 0);
+
+        BSPLib::Classic::Push(first.data(), 2 * sizeof(uint32_t));
+        BSPLib::Classic::Push(second.data(), 3 * sizeof(uint32_t));
+        BSPLib::Sync();
+
+        uint32_t value = s + i;
+        BSPLib::Classic::Put(to, &value, first.data(), sizeof(uint32_t), sizeof(uint32_t));
+        BSPLib::Classic::Put(to, &value, second.data(), 2 * sizeof(uint32_t), sizeof(uint32_t));
+        BSPLib::Classic::Put(to, &value, &persistent, 0, sizeof(uint32_t));
+
+        BSPLib::Classic::Pop(second.data());
+        BSPLib::Classic::Pop(first.data());
+        BSPLib::Sync();
+
+        EXPECT_EQ(from + i, first[1]);
+        EXPECT_EQ(from + i, second[2]);
+        EXPECT_EQ(from + i, persistent);
+    }
+
+    BSPLib::Classic::Pop(&persistent);
+    BSPLib::Sync();
+}
+
 template< uint32_t tPuts, int32_t tOffset >
 void PutTest()
 {
@@ -206,6 +246,50 @@ void PutTest()
     BSPLib::Classic::Pop(&receive);
 }
 
+template< uint32_t tPuts, int32_t tOffset >
+void HPPutTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+    uint32_t to = (s + tOffset + nProc) % nProc;
+
+    uint32_t expected = ((s - tOffset + nProc) % nProc) + 1;
+
+    std::vector< uint32_t > nums(tPuts, s + 1);
+    std::vector< uint32_t > receive(tPuts, 0);
+
+    BSPLib::Classic::Push(receive.data(), tPuts * sizeof(uint32_t));
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tPuts; ++i)
+    {
+        BSPLib::Classic::HPPut(to, &nums[i], receive.data(), i * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tPuts; ++i)
+    {
+        EXPECT_EQ(expected, receive[i]);
+    }
+
+    // Overlapping unbuffered puts are applied in the order they were issued, so the last one wins
+    std::vector< uint32_t > overwrites(tPuts);
+
+    for (uint32_t i = 0; i < tPuts; ++i)
+    {
+        overwrites[i] = 1000 * (s + 1) + i;
+        BSPLib::Classic::HPPut(to, &overwrites[i], receive.data(), 0, sizeof(uint32_t));
+    }
+
+    BSPLib::Sync();
+
+    EXPECT_EQ(1000 * expected + tPuts - 1, receive[0]);
+
+    BSPLib::Classic::Pop(receive.data());
+}
+
 template< uint32_t tGets, int32_t tOffset >
 void GetTest()
 {
@@ -238,6 +322,91 @@ void GetTest()
     BSPLib::Pop(&num);
 }
 
+template< uint32_t tGets, int32_t tOffset >
+void HPGetTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+    uint32_t from = (s + tOffset + nProc) % nProc;
+
+    std::vector< uint32_t > nums(tGets);
+    std::vector< uint32_t > receive(tGets, 0);
+
+    for (uint32_t i = 0; i < tGets; ++i)
+    {
+        nums[i] = s * tGets + i;
+    }
+
+    BSPLib::Classic::Push(nums.data(), tGets * sizeof(uint32_t));
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tGets; ++i)
+    {
+        BSPLib::Classic::HPGet(from, nums.data(), i * sizeof(uint32_t), &receive[i], sizeof(uint32_t));
+    }
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tGets; ++i)
+    {
+        EXPECT_EQ(from * tGets + i, receive[i]);
+    }
+
+    // Gets into the same destination are applied in the order they were issued, so the last one wins
+    uint32_t last = 0;
+
+    for (uint32_t i = 0; i < tGets; ++i)
+    {
+        BSPLib::Classic::HPGet(from, nums.data(), i * sizeof(uint32_t), &last, sizeof(uint32_t));
+        BSPLib::Classic::Get(from, nums.data(), i * sizeof(uint32_t), &receive[0], sizeof(uint32_t));
+    }
+
+    BSPLib::Sync();
+
+    EXPECT_EQ(from * tGets + tGets - 1, last);
+    EXPECT_EQ(from * tGets + tGets - 1, receive[0]);
+
+    BSPLib::Classic::Pop(nums.data());
+}
+
+template< uint32_t tRounds, int32_t tOffset >
+void HPGetBeforePutTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sRetrieve = (s + tOffset + nProc) % nProc;
+    uint32_t sReceive = (s - tOffset + nProc) % nProc;
+
+    uint32_t num = s + 1;
+    uint32_t retrieved = 0;
+    uint32_t newNum = 0;
+
+    BSPLib::Classic::Push(&num, sizeof(uint32_t));
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tRounds; ++i)
+    {
+        // The get must observe the value from before the put of this superstep
+        uint32_t expectedRetrieved = i == 0 ? sRetrieve + 1 : 1000 * i + (sRetrieve + tOffset + nProc) % nProc;
+
+        newNum = 1000 * (i + 1) + s;
+        BSPLib::Classic::HPGet(sRetrieve, &num, 0, &retrieved, sizeof(uint32_t));
+        BSPLib::Classic::Put(sReceive, &newNum, &num, 0, sizeof(uint32_t));
+
+        BSPLib::Sync();
+
+        EXPECT_EQ(expectedRetrieved, retrieved);
+        EXPECT_EQ(1000 * (i + 1) + sRetrieve, num);
+
+        retrieved = 0;
+    }
+
+    BSPLib::Classic::Pop(&num);
+}
+
 template< uint32_t tPutGets, int32_t tOffset >
 void MixedPutGetTest()
 {
@@ -494,6 +663,195 @@ void MultiSendTest()
     }
 }
 
+template< uint32_t tRounds, int32_t tOffset >
+void SendWhileReceivingTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sSend = (s + tOffset + nProc) % nProc;
+    uint32_t sReceive = (s - tOffset + nProc) % nProc;
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tRounds; ++i)
+    {
+        uint32_t message = s + i * nProc;
+
+        // Send the next messages before reading the messages received in the previous superstep
+        BSPLib::Classic::Send(sSend, NULL, &message, sizeof(uint32_t));
+        BSPLib::Classic::Send(sSend, NULL, &message, sizeof(uint32_t));
+
+        size_t packets = 0;
+        BSPLib::Classic::QSize(&packets, NULL);
+        EXPECT_EQ(i == 0 ? 0u : 2u, packets);
+
+        for (uint32_t j = 0; j < packets; ++j)
+        {
+            uint32_t mailbox = 0;
+            BSPLib::Classic::Move(&mailbox, sizeof(uint32_t));
+            EXPECT_EQ(sReceive + (i - 1) * nProc, mailbox);
+        }
+
+        BSPLib::Sync();
+    }
+
+    BSPLib::Sync();
+
+    // Messages are only available in the superstep after they were sent
+    size_t packets = 0;
+    BSPLib::Classic::QSize(&packets, NULL);
+    EXPECT_EQ(0u, packets);
+}
+
+template< uint32_t tRounds, uint32_t tOffset >
+void PutOnlySuperstepsTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sPut = (s + tOffset) % nProc;
+    uint32_t sReceive = (s + nProc - tOffset % nProc) % nProc;
+
+    std::vector< uint32_t > values(tRounds, 0);
+
+    BSPLib::Classic::Push(values.data(), tRounds * sizeof(uint32_t));
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tRounds; ++i)
+    {
+        uint32_t value = sPut * tRounds + i + s;
+        BSPLib::Classic::Put(sPut, &value, values.data(), i * sizeof(uint32_t), sizeof(uint32_t));
+
+        // Let one processor lag behind, so the others put into the next superstep while it is still syncing
+        if (s == 0 && i % 8 == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        BSPLib::Sync();
+
+        for (uint32_t j = 0; j <= i; ++j)
+        {
+            EXPECT_EQ(s * tRounds + j + sReceive, values[j]);
+        }
+    }
+
+    BSPLib::Classic::Pop(values.data());
+    BSPLib::Sync();
+}
+
+template< uint32_t tCount >
+void PutCoalesceTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sPut = (s + 1) % nProc;
+
+    std::vector< uint32_t > values(tCount, 0);
+    std::vector< uint32_t > other(tCount, 0);
+
+    BSPLib::Classic::Push(values.data(), tCount * sizeof(uint32_t));
+    BSPLib::Classic::Push(other.data(), tCount * sizeof(uint32_t));
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        uint32_t value = sPut + i;
+        BSPLib::Classic::Put(sPut, &value, values.data(), i * sizeof(uint32_t), sizeof(uint32_t));
+
+        // Interleave puts to another register, and to ourselves, so not all puts can be merged
+        if (i % 7 == 0)
+        {
+            uint32_t otherValue = i;
+            BSPLib::Classic::Put(sPut, &otherValue, other.data(), i * sizeof(uint32_t), sizeof(uint32_t));
+            BSPLib::Classic::Put(s, &otherValue, other.data(), i * sizeof(uint32_t), sizeof(uint32_t));
+        }
+    }
+
+    // Overwrite the middle of the merged block, the last put should win
+    uint32_t overwrite[2] = { 0xdead, 0xbeef };
+    BSPLib::Classic::Put(sPut, overwrite, values.data(), (tCount / 2) * sizeof(uint32_t), sizeof(overwrite));
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        if (i == tCount / 2)
+        {
+            EXPECT_EQ(0xdeadu, values[i]);
+        }
+        else if (i == tCount / 2 + 1)
+        {
+            EXPECT_EQ(0xbeefu, values[i]);
+        }
+        else
+        {
+            EXPECT_EQ(s + i, values[i]);
+        }
+
+        EXPECT_EQ(i % 7 == 0 ? i : 0u, other[i]);
+    }
+
+    BSPLib::Classic::Pop(other.data());
+    BSPLib::Classic::Pop(values.data());
+    BSPLib::Sync();
+}
+
+template< uint32_t tRounds >
+void HPMoveTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    size_t tagSize = sizeof(uint32_t);
+
+    BSPLib::Classic::SetTagSize(&tagSize);
+
+    std::vector< uint64_t > message(s + 1, s + 1);
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tRounds; ++i)
+    {
+        for (uint32_t sOther = 0; sOther < nProc; ++sOther)
+        {
+            BSPLib::Classic::Send(sOther, &s, message.data(), message.size() * sizeof(uint64_t));
+        }
+
+        BSPLib::Sync();
+
+        std::vector< bool > haveReceived(nProc, false);
+
+        void *tagPtr = nullptr;
+        void *payloadPtr = nullptr;
+        size_t status;
+
+        while ((status = BSPLib::Classic::HPMove(&tagPtr, &payloadPtr)) != (size_t) - 1)
+        {
+            uint32_t tag;
+            memcpy(&tag, tagPtr, sizeof(uint32_t));
+
+            EXPECT_EQ((tag + 1) * sizeof(uint64_t), status);
+
+            for (uint32_t j = 0; j <= tag; ++j)
+            {
+                uint64_t mail;
+                memcpy(&mail, static_cast< char * >(payloadPtr) + j * sizeof(uint64_t), sizeof(uint64_t));
+                EXPECT_EQ(tag + 1, mail);
+            }
+
+            haveReceived[tag] = true;
+        }
+
+        for (auto received : haveReceived)
+        {
+            EXPECT_TRUE(received);
+        }
+    }
+}
+
 template< uint32_t tRounds, uint32_t tMaxSize, int32_t tOffset, typename tPrimitive >
 void BruteForceTest()
 {
@@ -667,6 +1025,12 @@ BspTest2(Classic, 16, PutTest, 7, 3);
 BspTest2(Classic, 32, PutTest, 7, 3);
 BspTest2(Classic, 32, PutTest, 100, 41);
 
+BspTest2(Classic, 2, HPPutTest, 2, 1);
+BspTest2(Classic, 4, HPPutTest, 2, 1);
+BspTest2(Classic, 8, HPPutTest, 4, 3);
+BspTest2(Classic, 16, HPPutTest, 7, 3);
+BspTest2(Classic, 32, HPPutTest, 7, 3);
+
 BspTest2(Classic, 2, GetTest, 2, 1);
 BspTest2(Classic, 4, GetTest, 2, 1);
 BspTest2(Classic, 8, GetTest, 2, 1);
@@ -680,6 +1044,16 @@ BspTest2(Classic, 16, GetTest, 7, 3);
 BspTest2(Classic, 32, GetTest, 7, 3);
 BspTest2(Classic, 32, GetTest, 100, 41);
 
+BspTest2(Classic, 2, HPGetTest, 2, 1);
+BspTest2(Classic, 4, HPGetTest, 2, 1);
+BspTest2(Classic, 8, HPGetTest, 4, 3);
+BspTest2(Classic, 16, HPGetTest, 7, 3);
+BspTest2(Classic, 32, HPGetTest, 7, 3);
+
+BspTest2(Classic, 2, HPGetBeforePutTest, 2, 1);
+BspTest2(Classic, 8, HPGetBeforePutTest, 4, 3);
+BspTest2(Classic, 32, HPGetBeforePutTest, 7, 3);
+
 BspTest2(Classic, 2, MixedPutGetTest, 2, 1);
 BspTest2(Classic, 4, MixedPutGetTest, 2, 1);
 BspTest2(Classic, 8, MixedPutGetTest, 2, 1);
@@ -773,6 +1147,27 @@ BspTest4(Classic, 32, QSizeTest, 10, 100, 17, 41);
 BspTest4(Classic, 32, QSizeTestOverload, 10, 100, 17, 41);
 BspTest4(Classic, 32, QSizeTestOverload2, 10, 100, 17, 41);
 
+BspTest2(Classic, 1, SendWhileReceivingTest, 10, 0);
+BspTest2(Classic, 8, SendWhileReceivingTest, 10, 3);
+BspTest2(Classic, 32, SendWhileReceivingTest, 10, 7);
+
+BspTest2(Classic, 1, PutOnlySuperstepsTest, 50, 0);
+BspTest2(Classic, 8, PutOnlySuperstepsTest, 50, 1);
+BspTest2(Classic, 32, PutOnlySuperstepsTest, 50, 5);
+
+BspTest1(Classic, 1, PushPopReuseTest, 20);
+BspTest1(Classic, 8, PushPopReuseTest, 50);
+BspTest1(Classic, 32, PushPopReuseTest, 20);
+
+BspTest1(Classic, 1, PutCoalesceTest, 50);
+BspTest1(Classic, 8, PutCoalesceTest, 50);
+BspTest1(Classic, 32, PutCoalesceTest, 1000);
+
+BspTest1(Classic, 1, HPMoveTest, 5);
+BspTest1(Classic, 2, HPMoveTest, 5);
+BspTest1(Classic, 8, HPMoveTest, 5);
+BspTest1(Classic, 32, HPMoveTest, 5);
+
 BspTest1(Classic, 2, MultiSendTest, 50);
 BspTest1(Classic, 4, MultiSendTest, 50);
 BspTest1(Classic, 8, MultiSendTest, 50);
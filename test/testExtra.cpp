@@ -25,7 +25,10 @@
  */
 #include "helper.h"
 
+#include <algorithm>
 #include <array>
+#include <random>
+#include <map>
 
 template< int32_t tOffset, typename tPrimitive >
 void PutPaddedPrimitiveTest()
@@ -84,6 +87,177 @@ void PutPaddedTwicePrimitiveTest()
     EXPECT_EQ(result, sSource + 1);
 }
 
+template< int32_t tOffset >
+void PopPaddedReuseTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sTarget = (s + tOffset + nProc) % nProc;
+    uint32_t sSource = (s - tOffset + nProc) % nProc;
+
+    uint32_t first = 0;
+    uint32_t second = 0;
+
+    // Half of the processors push padding, which they can only pop most recent first
+    if (s % 2 == 0)
+    {
+        BSPLib::Push();
+        BSPLib::Push();
+    }
+    else
+    {
+        BSPLib::Push(first);
+        BSPLib::Push(second);
+    }
+
+    BSPLib::Sync();
+
+    if (s % 2 == 0)
+    {
+        BSPLib::Pop();
+        BSPLib::Pop();
+    }
+    else
+    {
+        BSPLib::Pop(first);
+        BSPLib::Pop(second);
+    }
+
+    BSPLib::Sync();
+
+    // The new registers reuse the popped global IDs, which should be the same on all processors
+    uint32_t result = 0;
+    uint32_t other = 0;
+    BSPLib::Push(result);
+    BSPLib::Push(other);
+    BSPLib::Sync();
+
+    uint32_t value = s + 1;
+    BSPLib::Put(sTarget, value, result);
+    BSPLib::Sync();
+
+    EXPECT_EQ(sSource + 1, result);
+    EXPECT_EQ(0u, other);
+
+    BSPLib::Pop(other);
+    BSPLib::Pop(result);
+    BSPLib::Sync();
+}
+
+template< int32_t tOffset, uint32_t tPadding >
+void PopPaddedSeparateTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sTarget = (s + tOffset + nProc) % nProc;
+    uint32_t sSource = (s - tOffset + nProc) % nProc;
+
+    const bool padding = s % 2 == tPadding;
+    uint32_t first = 0;
+    uint32_t second = 0;
+
+    if (padding)
+    {
+        BSPLib::Push();
+        BSPLib::Push();
+    }
+    else
+    {
+        BSPLib::Push(first);
+        BSPLib::Push(second);
+    }
+
+    BSPLib::Sync();
+
+    // The padding is popped in separate supersteps, and the new registers reuse the popped global IDs each time
+    for (uint32_t step = 0; step < 2; ++step)
+    {
+        if (padding)
+        {
+            BSPLib::Pop();
+        }
+        else
+        {
+            BSPLib::Pop(step == 0 ? first : second);
+        }
+
+        BSPLib::Sync();
+
+        uint32_t result = 0;
+        BSPLib::Push(result);
+        BSPLib::Sync();
+
+        uint32_t value = s + 1 + step * 100;
+        BSPLib::Put(sTarget, value, result);
+        BSPLib::Sync();
+
+        EXPECT_EQ(sSource + 1 + step * 100, result);
+
+        BSPLib::Pop(result);
+        BSPLib::Sync();
+    }
+
+    EXPECT_EQ(0u, first);
+    EXPECT_EQ(0u, second);
+}
+
+template< int32_t tOffset, uint32_t tCount >
+void RegisterHandleTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sTarget = (s + tOffset + nProc) % nProc;
+    uint32_t sSource = (s - tOffset + nProc) % nProc;
+
+    std::vector< uint32_t > values(tCount, 0);
+    std::vector< uint32_t > gathered(tCount, 0);
+    uint32_t single = s + 1;
+    uint32_t received = 0;
+
+    BSPLib::Register< uint32_t > valuesReg = BSPLib::PushPtrs(values.data(), tCount);
+    BSPLib::Register< uint32_t > singleReg = BSPLib::Push(single);
+    BSPLib::Sync();
+
+    EXPECT_EQ(values.data(), valuesReg.Data());
+    EXPECT_EQ(tCount, valuesReg.Size());
+    EXPECT_NE(valuesReg.GlobalId(), singleReg.GlobalId());
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        uint32_t value = s * tCount + i;
+        BSPLib::Put(sTarget, value, valuesReg, i);
+    }
+
+    BSPLib::Get(sSource, singleReg, received);
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        EXPECT_EQ(sSource * tCount + i, values[i]);
+    }
+
+    EXPECT_EQ(sSource + 1, received);
+
+    // Handles and addresses refer to the same registers
+    BSPLib::GetPtrs(sTarget, valuesReg, 1, gathered.data(), tCount - 1);
+    BSPLib::PutPtrs(sTarget, &single, 1, values.data(), 0);
+    BSPLib::Sync();
+
+    for (uint32_t i = 1; i < tCount; ++i)
+    {
+        EXPECT_EQ(s * tCount + i, gathered[i - 1]);
+    }
+
+    EXPECT_EQ(sSource + 1, values[0]);
+
+    BSPLib::Pop(singleReg);
+    BSPLib::Pop(valuesReg);
+    BSPLib::Sync();
+}
+
 inline void BSPAbortMessageTest()
 {
     for (uint32_t i = 0; i < 100; ++i)
@@ -366,6 +540,63 @@ void TagPrimitiveStringOverloadTest()
     EXPECT_EQ(sizeof(uint32_t), status);
 }
 
+template< int32_t tOffset >
+void MessageRangeTest()
+{
+    uint32_t s = BSPLib::ProcId();
+    uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t sSend = (s + tOffset + nProc) % nProc;
+    uint32_t sReceive = (s - tOffset + nProc) % nProc;
+
+    std::vector< uint32_t > message(4, s + 1);
+
+    BSPLib::SetTagsize< uint32_t >();
+
+    BSPLib::Sync();
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        uint32_t tag = i;
+        BSPLib::SendContainer(sSend, tag, message);
+    }
+
+    BSPLib::Sync();
+
+    EXPECT_EQ(3u, BSPLib::Messages().size());
+
+    uint32_t count = 0;
+
+    for (auto mail : BSPLib::Messages())
+    {
+        EXPECT_EQ(count, mail.Tag< uint32_t >());
+        EXPECT_EQ(4u, mail.Count< uint32_t >());
+        EXPECT_EQ(sReceive + 1, mail.Payload< uint32_t >(3));
+
+        uint32_t payload[8] = {};
+        EXPECT_EQ(4u, mail.CopyPayload(payload, 8));
+        EXPECT_EQ(sReceive + 1, payload[3]);
+        ++count;
+    }
+
+    EXPECT_EQ(3u, count);
+
+    // Iterating does not consume messages, moving does
+    BSPInternal::MessageView mail = {};
+    EXPECT_TRUE(BSPLib::HPMove(mail));
+    EXPECT_EQ(0u, mail.Tag< uint32_t >());
+    EXPECT_EQ(2u, BSPLib::Messages().size());
+
+    uint32_t mailbox[4];
+    BSPLib::MoveCArray(mailbox);
+    EXPECT_EQ(sReceive + 1, mailbox[0]);
+
+    EXPECT_TRUE(BSPLib::HPMove(mail));
+    EXPECT_EQ(2u, mail.Tag< uint32_t >());
+    EXPECT_FALSE(BSPLib::HPMove(mail));
+    EXPECT_TRUE(BSPLib::Messages().empty());
+}
+
 BspTest2(Extra, 2, PutPaddedPrimitiveTest, 1, uint8_t);
 BspTest2(Extra, 4, PutPaddedPrimitiveTest, 3, uint8_t);
 BspTest2(Extra, 8, PutPaddedPrimitiveTest, 7, uint8_t);
@@ -408,6 +639,19 @@ BspTest2(Extra, 8, PutPaddedTwicePrimitiveTest, 7, uint64_t);
 BspTest2(Extra, 16, PutPaddedTwicePrimitiveTest, 5, uint64_t);
 BspTest2(Extra, 32, PutPaddedTwicePrimitiveTest, 13, uint64_t);
 
+BspTest2(Extra, 1, RegisterHandleTest, 0, 5);
+BspTest2(Extra, 8, RegisterHandleTest, 3, 10);
+BspTest2(Extra, 32, RegisterHandleTest, 13, 4);
+
+BspTest1(Extra, 2, PopPaddedReuseTest, 1);
+BspTest1(Extra, 8, PopPaddedReuseTest, 3);
+BspTest1(Extra, 32, PopPaddedReuseTest, 13);
+
+BspTest2(Extra, 2, PopPaddedSeparateTest, 1, 0);
+BspTest2(Extra, 2, PopPaddedSeparateTest, 1, 1);
+BspTest2(Extra, 8, PopPaddedSeparateTest, 3, 0);
+BspTest2(Extra, 32, PopPaddedSeparateTest, 13, 1);
+
 BspTest(Extra, 32, BSPAbortMessageTest);
 
 BspTest3(Extra, 8, TagVectorOverloadTest, uint32_t, 23, 5);
@@ -415,4 +659,1423 @@ BspTest3(Extra, 8, TagStdArrayOverloadTest, uint32_t, 23, 5);
 BspTest3(Extra, 8, TagCArrayOverloadTest, uint32_t, 23, 5);
 BspTest3(Extra, 8, TagCArrayOverloadTest2, uint32_t, 23, 5);
 BspTest2(Extra, 8, TagPrimitiveOverloadTest, 5, uint32_t);
-BspTest1(Extra, 8, TagPrimitiveStringOverloadTest, 5);
\ No newline at end of file
+BspTest1(Extra, 8, TagPrimitiveStringOverloadTest, 5);
+
+BspTest1(Extra, 1, MessageRangeTest, 0);
+BspTest1(Extra, 8, MessageRangeTest, 5);
+BspTest1(Extra, 32, MessageRangeTest, 13);
+TEST(P(Extra), CacheAlignedProcessorData)
+{
+    tProcessorsData processorsData(3);
+
+    for (auto &data : processorsData)
+    {
+        data.putRequests[0].resize(3);
+        data.tmpSendBufferStacks[0].resize(3);
+
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&data) % BSP_CACHE_LINE_SIZE);
+
+        for (auto &queue : data.putRequests[0])
+        {
+            EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&queue) % BSP_CACHE_LINE_SIZE);
+        }
+
+        for (auto &buffer : data.tmpSendBufferStacks[0])
+        {
+            EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&buffer) % BSP_CACHE_LINE_SIZE);
+        }
+    }
+}
+
+TEST(P(Extra), ProcessorDataAllocate)
+{
+    ProcessorData data;
+    EXPECT_EQ(0u, data.putRequests[0].size());
+
+    data.Allocate(4);
+    EXPECT_EQ(4u, data.putRequests[1].size());
+    EXPECT_EQ(4u, data.getRequests.size());
+    EXPECT_EQ(4u, data.tmpSendBufferStacks[1].size());
+
+    // Buffers of the right size are kept, so a reused processor keeps its memory
+    const auto *queues = data.hpPutRequests.data();
+    data.Allocate(4);
+    EXPECT_EQ(queues, data.hpPutRequests.data());
+
+    data.Allocate(2);
+    EXPECT_EQ(2u, data.tmpSendRequests[0].size());
+}
+
+TEST(P(Extra), PersistentWorkers)
+{
+    std::vector< std::thread::id > firstRun(8);
+    std::vector< std::thread::id > secondRun(8);
+    std::vector< uint32_t > sums(8, 0);
+
+    auto kernel = [&sums](std::vector< std::thread::id > &threads)
+    {
+        uint32_t s = BSPLib::ProcId();
+        uint32_t nProc = BSPLib::NProcs();
+        threads[s] = std::this_thread::get_id();
+
+        uint32_t sum = 0;
+        BSPLib::Push(sum);
+        BSPLib::Sync();
+
+        for (uint32_t round = 0; round < nProc; ++round)
+        {
+            uint32_t value = s + 1;
+            BSPLib::Put((s + round) % nProc, value, sum);
+            BSPLib::Sync();
+            sums[s] += sum;
+        }
+
+        BSPLib::Pop(sum);
+        BSPLib::Sync();
+    };
+
+    BSPLib::SetPersistentWorkers(true);
+
+    EXPECT_TRUE(BSPLib::Execute([&] { kernel(firstRun); }, 8));
+    EXPECT_TRUE(BSPLib::Execute([&] { kernel(secondRun); }, 8));
+
+    // A smaller program only uses part of the pool
+    EXPECT_TRUE(BSPLib::Execute([&] { kernel(secondRun); }, 3));
+
+    BSPLib::SetPersistentWorkers(false);
+
+    for (uint32_t s = 1; s < 8; ++s)
+    {
+        EXPECT_EQ(firstRun[s], secondRun[s]);
+    }
+
+    // Every processor receives every value 1..nProc once per program
+    for (uint32_t s = 0; s < 8; ++s)
+    {
+        EXPECT_EQ(s < 3 ? 2 * 36u + 6u : 2 * 36u, sums[s]);
+    }
+}
+
+TEST(P(Extra), PlacementOrder)
+{
+    // Two packages with two cores of two hardware threads each, numbered like Linux does on x86
+    std::vector< BSPInternal::CpuInfo > cpus;
+
+    for (uint32_t cpu = 0; cpu < 8; ++cpu)
+    {
+        BSPInternal::CpuInfo info;
+        info.cpu = cpu;
+        info.package = (cpu % 4) / 2;
+        info.core = cpu % 2;
+        cpus.push_back(info);
+    }
+
+    std::vector< uint32_t > none;
+
+    EXPECT_EQ(std::vector< uint32_t >({ 0, 4, 1, 5, 2, 6, 3, 7 }),
+              BSPInternal::ThreadPlacement::Order(cpus, BSPLib::Placement::Compact, none));
+    EXPECT_EQ(std::vector< uint32_t >({ 0, 1, 2, 3, 4, 5, 6, 7 }),
+              BSPInternal::ThreadPlacement::Order(cpus, BSPLib::Placement::OnePerCore, none));
+    EXPECT_EQ(std::vector< uint32_t >({ 0, 2, 1, 3, 4, 6, 5, 7 }),
+              BSPInternal::ThreadPlacement::Order(cpus, BSPLib::Placement::Scatter, none));
+    EXPECT_TRUE(BSPInternal::ThreadPlacement::Order(cpus, BSPLib::Placement::None, none).empty());
+
+    // CPUs outside of the allowed set are skipped
+    cpus.erase(cpus.begin() + 3);
+    EXPECT_EQ(std::vector< uint32_t >({ 6, 1 }),
+              BSPInternal::ThreadPlacement::Order(cpus, BSPLib::Placement::Explicit, { 6, 3, 1 }));
+}
+
+TEST(P(Extra), PlacementParse)
+{
+    BSPLib::Placement policy = BSPLib::Placement::None;
+    std::vector< uint32_t > explicitCpus;
+
+    EXPECT_TRUE(BSPInternal::ThreadPlacement::ParsePlacement("scatter", policy, explicitCpus));
+    EXPECT_EQ(BSPLib::Placement::Scatter, policy);
+
+    EXPECT_TRUE(BSPInternal::ThreadPlacement::ParsePlacement("cores", policy, explicitCpus));
+    EXPECT_EQ(BSPLib::Placement::OnePerCore, policy);
+
+    EXPECT_TRUE(BSPInternal::ThreadPlacement::ParsePlacement("0,2,4-6", policy, explicitCpus));
+    EXPECT_EQ(BSPLib::Placement::Explicit, policy);
+    EXPECT_EQ(std::vector< uint32_t >({ 0, 2, 4, 5, 6 }), explicitCpus);
+
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("4-", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("1,x", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("", policy, explicitCpus));
+
+    // Trailing junk, signs and empty bounds
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("0-3x", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("3x", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("0--1", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("-1", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("+1", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement(" 1", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("1-2-3", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("1,", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("3-1", policy, explicitCpus));
+
+    // Bounds beyond any CPU set are rejected before the range is expanded
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("0-4294967295", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("0-99999999999999999999", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("4294967296", policy, explicitCpus));
+    EXPECT_FALSE(BSPInternal::ThreadPlacement::ParsePlacement("1000000", policy, explicitCpus));
+
+    // The valid list from before is kept when a description is rejected
+    EXPECT_EQ(std::vector< uint32_t >({ 0, 2, 4, 5, 6 }), explicitCpus);
+
+    EXPECT_TRUE(BSPInternal::ThreadPlacement::ParsePlacement("7,1-1,010", policy, explicitCpus));
+    EXPECT_EQ(std::vector< uint32_t >({ 7, 1, 10 }), explicitCpus);
+}
+
+#if defined(__linux__)
+TEST(P(Extra), PlacementExplicit)
+{
+    std::vector< int > cpus(4, -1);
+
+    BSPLib::SetPlacement(std::vector< uint32_t >({ 0 }));
+
+    EXPECT_TRUE(BSPLib::Execute([&cpus]
+    {
+        cpus[BSPLib::ProcId()] = sched_getcpu();
+    }, 4));
+
+    BSPLib::SetPlacement(BSPLib::Placement::OnePerCore);
+
+    for (int cpu : cpus)
+    {
+        EXPECT_EQ(0, cpu);
+    }
+}
+#endif
+
+template< typename tRegisterMap >
+void RegisterMapTest()
+{
+    tRegisterMap registers;
+    std::map< const void *, std::vector< uint32_t > > expected;
+    std::vector< char > memory(50000);
+    std::mt19937 rng(42);
+
+    for (uint32_t globalId = 0; globalId < 20000; ++globalId)
+    {
+        const void *reg = &memory[rng() % memory.size()];
+
+        // Erase some registers, so later pushes of them have to be found again
+        if (rng() % 3 == 0 && !expected.empty())
+        {
+            auto erased = expected.lower_bound(reg);
+            erased = erased == expected.end() ? expected.begin() : erased;
+            EXPECT_EQ(erased->second.back(), registers.Erase(erased->first));
+            erased->second.pop_back();
+
+            if (erased->second.empty())
+            {
+                expected.erase(erased);
+            }
+        }
+
+        BSPInternal::RegisterInfo info = { 4, globalId };
+        registers.Insert(reg, info);
+        expected[reg].push_back(globalId);
+
+        EXPECT_EQ(reg, registers.GlobalToLocal(globalId));
+        EXPECT_EQ(globalId, registers.LocalToGlobal(reg));
+    }
+
+    EXPECT_EQ(20000u, registers.GetSize());
+
+    for (const auto &reg : expected)
+    {
+        EXPECT_EQ(reg.second.back(), registers.LocalToGlobal(reg.first));
+        EXPECT_EQ(reg.first, registers.LookupGlobal(reg.second.back()));
+    }
+
+    // A popped global ID can be taken by another register
+    auto popped = std::find_if(expected.begin(), expected.end(), [](const std::pair< const void *const, std::vector< uint32_t > > &reg)
+    {
+        return reg.second.size() == 1;
+    });
+    ASSERT_NE(expected.end(), popped);
+
+    const uint32_t poppedId = popped->second.back();
+    EXPECT_EQ(poppedId, registers.Erase(popped->first));
+    EXPECT_EQ((uint32_t)(-1), registers.Erase(popped->first));
+
+    BSPInternal::RegisterInfo reused = { 4, poppedId };
+    registers.Insert(&memory.back() + 1, reused);
+    EXPECT_EQ(poppedId, registers.LocalToGlobal(&memory.back() + 1));
+    EXPECT_EQ(&memory.back() + 1, registers.GlobalToLocal(poppedId));
+    EXPECT_EQ(20000u, registers.GetSize());
+
+    // A register that is pushed twice, such as padding, is popped most recent first
+    BSPInternal::RegisterInfo outer = { 4, 20000 };
+    BSPInternal::RegisterInfo inner = { 4, 20001 };
+    registers.Insert(nullptr, outer);
+    registers.Insert(nullptr, inner);
+    EXPECT_EQ(20001u, registers.LocalToGlobal(nullptr));
+    EXPECT_EQ(20001u, registers.Erase(nullptr));
+    EXPECT_EQ(20000u, registers.LocalToGlobal(nullptr));
+    EXPECT_EQ(20000u, registers.Erase(nullptr));
+    EXPECT_EQ((uint32_t)(-1), registers.Erase(nullptr));
+
+    registers.Clear();
+    EXPECT_EQ(0u, registers.GetSize());
+
+    BSPInternal::RegisterInfo info = { 4, 0 };
+    registers.Insert(&memory[0], info);
+    EXPECT_EQ(0u, registers.LocalToGlobal(&memory[0]));
+}
+
+TEST(P(Extra), RegisterVector)
+{
+    RegisterMapTest< BSPInternal::ThreadRegisterVector >();
+}
+
+TEST(P(Extra), RegisterMap)
+{
+    RegisterMapTest< BSPInternal::ThreadRegisterMap >();
+}
+
+TEST(P(Extra), RegisterHash)
+{
+    RegisterMapTest< BSPInternal::ThreadRegisterHash >();
+}
+
+template< typename tStackMemory >
+void StackMemoryTest()
+{
+    tStackMemory memory(100);
+    EXPECT_LE(100u, memory.Capacity());
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        memory.Data()[i] = static_cast<char>(i);
+    }
+
+    // Grow far beyond the first pages, the used bytes should be kept
+    memory.Grow(size_t(8) << 20, 100);
+    EXPECT_LE(size_t(8) << 20, memory.Capacity());
+    memory.Data()[(size_t(8) << 20) - 1] = 1;
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(static_cast<char>(i), memory.Data()[i]);
+    }
+
+    tStackMemory moved(std::move(memory));
+    EXPECT_EQ(static_cast<char>(99), moved.Data()[99]);
+}
+
+TEST(P(Extra), HeapStackMemory)
+{
+    StackMemoryTest< BSPInternal::HeapStackMemory >();
+}
+
+#if defined(__linux__)
+TEST(P(Extra), MappedStackMemory)
+{
+    StackMemoryTest< BSPInternal::MappedStackMemory >();
+}
+#endif
+
+TEST(P(Extra), StackAllocatorGrow)
+{
+    BSPInternal::StackAllocator stack(16);
+    std::vector< BSPInternal::StackAllocator::StackLocation > locations;
+
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        locations.push_back(stack.Alloc(sizeof(uint32_t), reinterpret_cast<const char *>(&i)));
+    }
+
+    BSPInternal::StackAllocator copy(stack);
+
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        uint32_t value = 0;
+        copy.Extract(locations[i], sizeof(uint32_t), reinterpret_cast<char *>(&value));
+        EXPECT_EQ(i, value);
+    }
+}
+
+TEST(P(Extra), StackAllocatorAllocFixed)
+{
+    BSPInternal::StackAllocator stack(16);
+    std::vector< BSPInternal::StackAllocator::StackLocation > locations;
+
+    // Fixed size allocations grow the stack like the others, and may be mixed with them
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        locations.push_back(stack.AllocFixed< sizeof(uint64_t) >(reinterpret_cast<const char *>(&i)));
+        stack.Alloc(1, "x");
+    }
+
+    EXPECT_EQ(1000 * (sizeof(uint64_t) + 1), static_cast<size_t>(stack.Size()));
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        uint64_t value = 0;
+        stack.Extract(locations[i], sizeof(uint64_t), reinterpret_cast<char *>(&value));
+        EXPECT_EQ(i, value);
+    }
+}
+
+TEST(P(Extra), BufferUsageShrink)
+{
+    BSPInternal::BufferPolicy &policy = BSPInternal::GetBufferPolicy();
+    const BSPInternal::BufferPolicy defaults = policy;
+    policy.decay = 0.5f;
+    policy.shrinkAfter = 4;
+
+    BSPInternal::BufferUsage usage;
+    EXPECT_EQ(0u, usage.Record(1000, 1024, 16));
+    EXPECT_EQ(1000u, usage.HighWater());
+
+    // A burst before the shrink is due keeps the memory
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(0u, usage.Record(0, 1024, 16));
+    }
+
+    EXPECT_EQ(0u, usage.Record(900, 1024, 16));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(0u, usage.Record(0, 1024, 16));
+    }
+
+    // Shrinks to twice the decayed high-water mark, but never below the minimum
+    EXPECT_EQ(112u, usage.Record(0, 1024, 16));
+    EXPECT_EQ(0u, usage.Record(0, 16, 16));
+
+    policy.shrinkAfter = 0;
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(0u, usage.Record(0, 1024, 16));
+    }
+
+    policy = defaults;
+}
+
+TEST(P(Extra), StackAllocatorShrink)
+{
+    BSPInternal::BufferPolicy &policy = BSPInternal::GetBufferPolicy();
+    const BSPInternal::BufferPolicy defaults = policy;
+    policy.decay = 0.5f;
+    policy.shrinkAfter = 4;
+
+    BSPInternal::StackAllocator stack(64);
+    std::vector< char > burst(100000, 'a');
+    stack.Alloc(burst.size(), burst.data());
+    const size_t capacity = stack.Capacity();
+    stack.Clear();
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        stack.Clear();
+    }
+
+    // The memory is only released on the next allocation
+    EXPECT_EQ(capacity, stack.Capacity());
+
+    uint32_t value = 42;
+    BSPInternal::StackAllocator::StackLocation location = stack.Alloc(sizeof(uint32_t), reinterpret_cast<const char *>(&value));
+    EXPECT_LT(stack.Capacity(), capacity);
+    EXPECT_GE(stack.Capacity(), 64u);
+
+    uint32_t result = 0;
+    stack.Extract(location, sizeof(uint32_t), reinterpret_cast<char *>(&result));
+    EXPECT_EQ(42u, result);
+
+    // Reserved memory is never released
+    stack.Reserve(50000);
+    const size_t reserved = stack.Capacity();
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        stack.Clear();
+    }
+
+    stack.Alloc(sizeof(uint32_t), reinterpret_cast<const char *>(&value));
+    EXPECT_EQ(reserved, stack.Capacity());
+
+    policy = defaults;
+}
+
+TEST(P(Extra), RequestVectorShrink)
+{
+    BSPInternal::BufferPolicy &policy = BSPInternal::GetBufferPolicy();
+    const BSPInternal::BufferPolicy defaults = policy;
+    policy.decay = 0.5f;
+    policy.shrinkAfter = 4;
+
+    BSPInternal::RequestVector< BSPInternal::GetRequest > queue;
+
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        queue.InitRequest().globalId = i;
+    }
+
+    const size_t capacity = queue.Capacity();
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        queue.Clear();
+    }
+
+    queue.InitRequest().globalId = 7;
+    EXPECT_LT(queue.Capacity(), capacity);
+    EXPECT_GE(queue.Capacity(), 10u);
+    EXPECT_EQ(7u, queue[0].globalId);
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        queue.Clear();
+    }
+
+    // Appending releases the memory as well, but still makes room for the appended requests
+    std::vector< BSPInternal::GetRequest > requests(20);
+    queue.Append(requests.begin(), requests.end());
+    EXPECT_EQ(20u, queue.GetSize());
+
+    policy = defaults;
+}
+
+TEST(P(Extra), BufferPolicyBursts)
+{
+    BSPLib::BufferPolicy policy;
+    policy.hRelation = 1 << 16;
+    policy.shrinkAfter = 2;
+    BSPLib::SetBufferPolicy(policy);
+
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        std::vector< uint32_t > values(4096, 0);
+        BSPLib::Register< uint32_t > reg = BSPLib::PushPtrs(values.data(), values.size());
+        BSPLib::Sync();
+
+        for (uint32_t superstep = 0; superstep < 16; ++superstep)
+        {
+            // Every fourth superstep is a burst, with sparse supersteps in between that release the memory
+            const uint32_t count = superstep % 4 == 0 ? 4096 : 1;
+            std::vector< uint32_t > source(count, s * 100 + superstep);
+            BSPLib::PutPtrs((s + 1) % nProc, source.data(), count, reg, 0);
+            BSPLib::Sync();
+
+            const uint32_t expected = ((s + nProc - 1) % nProc) * 100 + superstep;
+            EXPECT_EQ(expected, values[0]);
+            EXPECT_EQ(expected, values[count - 1]);
+        }
+
+        BSPLib::Pop(reg);
+        BSPLib::Sync();
+    }, 4);
+
+    BSPLib::SetBufferPolicy(BSPLib::BufferPolicy());
+}
+
+TEST(P(Extra), ProcessorDataReserve)
+{
+    ProcessorData data;
+    data.Allocate(4);
+
+    BSPInternal::CommunicationVolume volume;
+    volume.puts = 1000;
+    volume.putBytes = 40000;
+    volume.gets = 300;
+    volume.sends = 500;
+    volume.sendBytes = 20000;
+    data.Reserve(1, 4, volume);
+    data.Reserve(2, 4, volume);
+
+    EXPECT_GE(data.putRequests[0][1].Capacity(), 1000u);
+    EXPECT_GE(data.getRequests[2].Capacity(), 300u);
+    EXPECT_GE(data.tmpSendRequests[0][2].Capacity(), 500u);
+    EXPECT_GT(data.tmpSendBufferStacks[0][1].Capacity(), 20000u);
+    // The puts to all processors share one buffer
+    EXPECT_GT(data.putBufferStacks[0].Capacity(), 80000u);
+
+    // The other set is reserved when the processor switches to it
+    EXPECT_LT(data.putRequests[1][1].Capacity(), 1000u);
+    data.putSet ^= 1;
+    data.ReservePuts();
+    EXPECT_GE(data.putRequests[1][1].Capacity(), 1000u);
+    EXPECT_GT(data.putBufferStacks[1].Capacity(), 80000u);
+
+    const size_t capacity = data.putRequests[1][2].Capacity();
+    const size_t bytes = data.putBufferStacks[1].Capacity();
+    const uint64_t payload[5] = {};
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        data.putRequests[1][2].InitRequest();
+        data.putBufferStacks[1].Alloc(sizeof(payload), reinterpret_cast<const char *>(payload));
+    }
+
+    EXPECT_EQ(capacity, data.putRequests[1][2].Capacity());
+    EXPECT_EQ(bytes, data.putBufferStacks[1].Capacity());
+}
+
+TEST(P(Extra), ReserveCommunication)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        const uint32_t count = 2000;
+
+        size_t tagSize = sizeof(uint32_t);
+        BSPLib::Classic::SetTagSize(&tagSize);
+        std::vector< uint32_t > values(count, 0);
+        BSPLib::Register< uint32_t > reg = BSPLib::PushPtrs(values.data(), values.size());
+        BSPLib::Sync();
+
+        for (uint32_t target = 0; target < nProc; ++target)
+        {
+            BSPLib::CommunicationVolume volume;
+            volume.puts = count;
+            volume.putBytes = count * sizeof(uint32_t);
+            volume.sends = count;
+            volume.sendBytes = count * sizeof(uint32_t);
+            BSPLib::ReserveCommunication(target, volume);
+        }
+
+        for (uint32_t superstep = 0; superstep < 4; ++superstep)
+        {
+            const uint32_t target = (s + 1) % nProc;
+
+            // Strided, so the puts cannot be merged
+            for (uint32_t i = 0; i < count; i += 2)
+            {
+                const uint32_t value = s * count + i + superstep;
+                BSPLib::Put(target, value, reg, i);
+                BSPLib::SendPtrs(target, &i, &value, 1);
+            }
+
+            BSPLib::Sync();
+
+            const uint32_t source = (s + nProc - 1) % nProc;
+            size_t packets = 0;
+            size_t accumulatedSize = 0;
+            BSPLib::Classic::QSize(&packets, &accumulatedSize);
+            EXPECT_EQ(count / 2, packets);
+
+            for (uint32_t i = 0; i < count; i += 2)
+            {
+                EXPECT_EQ(source * count + i + superstep, values[i]);
+
+                uint32_t message = 0;
+                BSPLib::Move(message);
+                EXPECT_EQ(source * count + i + superstep, message);
+            }
+        }
+
+        BSPLib::Pop(reg);
+        BSPLib::Sync();
+    }, 4);
+}
+
+TEST(P(Extra), CompactRequests)
+{
+    EXPECT_EQ(16u, sizeof(BSPInternal::PutRequest));
+    EXPECT_EQ(8u, sizeof(BSPInternal::SendRequest));
+    EXPECT_EQ(24u, sizeof(BSPInternal::GetRequest));
+}
+
+TEST(P(Extra), TagAfterPayload)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        const uint32_t target = (s + 1) % nProc;
+
+        size_t tagSize = sizeof(uint16_t);
+        BSPLib::Classic::SetTagSize(&tagSize);
+        BSPLib::Sync();
+
+        // Payloads of every size up to a few words, so the tags are stored at unaligned locations
+        std::vector< char > payload(33);
+
+        for (uint16_t size = 0; size < payload.size(); ++size)
+        {
+            std::fill(payload.begin(), payload.begin() + size, static_cast<char>(s + size));
+            BSPLib::Classic::Send(target, &size, payload.data(), size);
+        }
+
+        BSPLib::Sync();
+
+        const uint32_t source = (s + nProc - 1) % nProc;
+
+        for (uint16_t size = 0; size < payload.size(); ++size)
+        {
+            BSPInternal::MessageView view = BSP::GetInstance().PeekMessage(size);
+            EXPECT_EQ(size, view.size);
+            EXPECT_EQ(sizeof(uint16_t), view.tagSize);
+
+            size_t status = 0;
+            uint16_t tag = 0;
+            BSPLib::Classic::GetTag(&status, &tag);
+            EXPECT_EQ(size, status);
+            EXPECT_EQ(size, tag);
+
+            std::vector< char > received(size + 1, 0);
+            BSPLib::Classic::Move(received.data(), size);
+
+            for (uint16_t i = 0; i < size; ++i)
+            {
+                EXPECT_EQ(static_cast<char>(source + size), received[i]);
+            }
+        }
+    }, 3);
+}
+
+TEST(P(Extra), InlinePutRequest)
+{
+    BSPInternal::PutRequest request;
+    request.offset = 16;
+    request.SetInline(42, 8);
+
+    EXPECT_TRUE(request.IsInline());
+    EXPECT_FALSE(request.IsWide());
+    EXPECT_EQ(42u, request.GlobalId());
+    EXPECT_EQ(8u, request.Size());
+    EXPECT_EQ(1u, request.Records());
+
+    request.globalId = 42;
+    request.size = 100;
+    EXPECT_FALSE(request.IsInline());
+    EXPECT_EQ(100u, request.Size());
+    EXPECT_EQ(1u, request.Records());
+}
+
+TEST(P(Extra), InlinePutRecords)
+{
+    EXPECT_EQ(1u, BSPInternal::PutRequest::InlineRecords(8));
+    EXPECT_EQ(2u, BSPInternal::PutRequest::InlineRecords(12));
+    EXPECT_EQ(2u, BSPInternal::PutRequest::InlineRecords(24));
+    EXPECT_EQ(3u, BSPInternal::PutRequest::InlineRecords(25));
+    EXPECT_EQ(3u, BSPInternal::PutRequest::InlineRecords(BSPInternal::PutRequest::InlineCapacity));
+
+    BSPInternal::PutRequestVector queue;
+    std::array< uint8_t, 24 > value;
+
+    for (uint8_t i = 0; i < value.size(); ++i)
+    {
+        value[i] = i + 1;
+    }
+
+    const double scalar = 3.5;
+
+    // The payload continues in the records after the request
+    queue.InitInline< sizeof(double) >(6, 0, reinterpret_cast<const char *>(&scalar));
+    queue.InitInline< 24 >(7, 4, reinterpret_cast<const char *>(value.data()));
+    const size_t index = queue.LastPut();
+    queue.InitBuffered(8, 0, 0, 16);
+
+    const BSPInternal::PutRequest &request = queue[index];
+    EXPECT_EQ(1u, index);
+    EXPECT_TRUE(request.IsInline());
+    EXPECT_EQ(7u, request.GlobalId());
+    EXPECT_EQ(4u, request.offset);
+    EXPECT_EQ(24u, request.Size());
+    EXPECT_EQ(2u, request.Records());
+    EXPECT_EQ(4u, queue.GetSize());
+    EXPECT_EQ(3u, queue.PutCount());
+    EXPECT_EQ(3u, queue.LastPut());
+    EXPECT_EQ(8u, queue[3].GlobalId());
+
+    double scalarResult = 0;
+    queue.CopyInline(0, reinterpret_cast<char *>(&scalarResult));
+    EXPECT_EQ(scalar, scalarResult);
+
+    std::array< uint8_t, BSPInternal::PutRequest::InlineCapacity > result = {};
+    queue.CopyInline(index, reinterpret_cast<char *>(result.data()));
+    EXPECT_TRUE(std::equal(value.begin(), value.end(), result.begin()));
+    EXPECT_EQ(0u, result[value.size()]);
+}
+
+TEST(P(Extra), WidePutRequest)
+{
+    const uint64_t last32 = std::numeric_limits< uint32_t >::max();
+    EXPECT_EQ(1u, BSPInternal::PutRequest::BufferedRecords(last32));
+    EXPECT_EQ(2u, BSPInternal::PutRequest::BufferedRecords(last32 + 1));
+
+    BSPInternal::PutRequestVector queue;
+
+    // The last location that fits in the request itself
+    queue.InitBuffered(42, 8, last32, 100);
+    const size_t narrow = queue.LastPut();
+
+    EXPECT_FALSE(queue[narrow].IsWide());
+    EXPECT_EQ(1u, queue[narrow].Records());
+    EXPECT_EQ(last32, queue.BufferLocation(narrow));
+
+    // Locations beyond 4 GiB are kept in full in an extension record
+    const uint64_t location = (uint64_t(5) << 32) + 24;
+    queue.InitBuffered(43, 16, location, 200);
+    const size_t wide = queue.LastPut();
+
+    EXPECT_EQ(1u, wide);
+    EXPECT_TRUE(queue[wide].IsWide());
+    EXPECT_FALSE(queue[wide].IsInline());
+    EXPECT_EQ(2u, queue[wide].Records());
+    EXPECT_EQ(location, queue.BufferLocation(wide));
+    EXPECT_EQ(43u, queue[wide].GlobalId());
+    EXPECT_EQ(200u, queue[wide].Size());
+    EXPECT_EQ(16u, queue[wide].offset);
+
+    EXPECT_EQ(3u, queue.GetSize());
+    EXPECT_EQ(2u, queue.PutCount());
+
+    // Walking the queue by records visits both puts
+    std::vector< uint64_t > locations;
+
+    for (size_t index = 0; index < queue.GetSize(); index += queue[index].Records())
+    {
+        locations.push_back(queue.BufferLocation(index));
+    }
+
+    EXPECT_EQ(std::vector< uint64_t >({ last32, location }), locations);
+
+    queue.Clear();
+    EXPECT_EQ(0u, queue.PutCount());
+    EXPECT_TRUE(queue.Empty());
+}
+
+template< size_t tSize >
+struct SmallValue
+{
+    uint8_t bytes[tSize];
+};
+
+template< typename tValue >
+void InlinePutTest()
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        const uint32_t target = (s + 1) % nProc;
+        const uint32_t count = 64;
+
+        auto make = [](uint32_t seed)
+        {
+            tValue value;
+            memset(&value, 0, sizeof(tValue));
+            memcpy(&value, &seed, std::min(sizeof(tValue), sizeof(uint32_t)));
+            return value;
+        };
+
+        std::vector< tValue > values(count, make(0));
+        tValue single = make(0);
+        BSPLib::Register< tValue > reg = BSPLib::PushPtrs(values.data(), values.size());
+        BSPLib::Push(single);
+        BSPLib::Sync();
+
+        for (uint32_t superstep = 0; superstep < 3; ++superstep)
+        {
+            // Element wise puts, which start inline and are merged into a block once they continue each other
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                BSPLib::Put(target, make(s + i + superstep), reg, i);
+
+                // Interleaved scalar puts to another register
+                if (i % 5 == 0)
+                {
+                    tValue scalar = make(s * 1000 + i + superstep);
+                    BSPLib::Put(target, scalar, single);
+                }
+            }
+
+            // The last put to a location wins, whether it is inline or buffered
+            const tValue overwrite[2] = { make(0xbeef), make(0xdead) };
+            BSPLib::PutPtrs(target, overwrite, 2, reg, 10);
+            BSPLib::Put(target, make(0xcafe), reg, 11);
+
+            BSPLib::Sync();
+
+            const uint32_t source = (s + nProc - 1) % nProc;
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint32_t expected = i == 10 ? 0xbeef : i == 11 ? 0xcafe : source + i + superstep;
+                const tValue expectedValue = make(expected);
+                EXPECT_EQ(0, memcmp(&expectedValue, &values[i], sizeof(tValue))) << i;
+            }
+
+            const tValue expectedSingle = make(source * 1000 + 60 + superstep);
+            EXPECT_EQ(0, memcmp(&expectedSingle, &single, sizeof(tValue)));
+        }
+
+        BSPLib::Pop(single);
+        BSPLib::Pop(reg);
+        BSPLib::Sync();
+    }, 4);
+}
+
+TEST(P(Extra), InlinePut1)
+{
+    InlinePutTest< uint8_t >();
+}
+
+TEST(P(Extra), InlinePut4)
+{
+    InlinePutTest< uint32_t >();
+}
+
+TEST(P(Extra), InlinePut8)
+{
+    InlinePutTest< double >();
+}
+
+TEST(P(Extra), InlinePut12)
+{
+    InlinePutTest< SmallValue< 12 > >();
+}
+
+TEST(P(Extra), InlinePut16)
+{
+    InlinePutTest< SmallValue< 16 > >();
+}
+
+TEST(P(Extra), InlinePut24)
+{
+    InlinePutTest< SmallValue< 24 > >();
+}
+
+TEST(P(Extra), InlinePut27)
+{
+    InlinePutTest< SmallValue< 27 > >();
+}
+
+TEST(P(Extra), InlinePut32)
+{
+    InlinePutTest< SmallValue< 32 > >();
+}
+
+TEST(P(Extra), InlinePut40)
+{
+    InlinePutTest< SmallValue< 40 > >();
+}
+
+template< uint32_t tCount >
+void CollectivesTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    std::vector< uint64_t > values(tCount);
+    std::vector< uint64_t > result(tCount, 0);
+
+    auto fill = [&](uint32_t round)
+    {
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            values[i] = (s + 1) * 1000 + i + round;
+        }
+    };
+
+    auto sum = [&](uint32_t end, uint32_t i, uint32_t round)
+    {
+        uint64_t total = 0;
+
+        for (uint32_t pid = 0; pid < end; ++pid)
+        {
+            total += (pid + 1) * 1000 + i + round;
+        }
+
+        return total;
+    };
+
+    // Consecutive collectives without a sync in between alternate between the slots of the processors
+    for (uint32_t round = 0; round < 4; ++round)
+    {
+        const uint32_t root = (round + 1) % nProc;
+
+        fill(round);
+        BSPLib::Collectives::Broadcast(values.data(), tCount, root);
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ((root + 1) * 1000 + i + round, values[i]);
+        }
+
+        fill(round);
+        std::fill(result.begin(), result.end(), 0);
+        BSPLib::Collectives::Reduce(values.data(), result.data(), tCount, root);
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ(s == root ? sum(nProc, i, round) : 0, result[i]);
+        }
+
+        BSPLib::Collectives::AllReduce(values.data(), result.data(), tCount);
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ(sum(nProc, i, round), result[i]);
+        }
+
+        // In place, where the values may still be read by the others
+        BSPLib::Collectives::InclusiveScan(values.data(), values.data(), tCount);
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ(sum(s + 1, i, round), values[i]);
+        }
+
+        fill(round);
+        BSPLib::Collectives::ExclusiveScan(values.data(), values.data(), tCount, uint64_t(0));
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ(sum(s, i, round), values[i]);
+        }
+
+        fill(round);
+        BSPLib::Collectives::AllReduce(values.data(), values.data(), tCount, [](uint64_t a, uint64_t b)
+        {
+            return std::max(a, b);
+        });
+
+        for (uint32_t i = 0; i < tCount; ++i)
+        {
+            EXPECT_EQ(nProc * 1000 + i + round, values[i]);
+        }
+
+        fill(round);
+        std::vector< uint64_t > gathered(nProc * tCount);
+        std::copy(values.begin(), values.end(), gathered.begin() + s * tCount);
+        BSPLib::Collectives::AllGather(gathered.data() + s * tCount, tCount, gathered.data());
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            for (uint32_t i = 0; i < tCount; ++i)
+            {
+                EXPECT_EQ((pid + 1) * 1000 + i + round, gathered[pid * tCount + i]);
+            }
+        }
+    }
+}
+
+BspTest1(Extra, 1, CollectivesTest, 4);
+BspTest1(Extra, 3, CollectivesTest, 4);
+BspTest1(Extra, 8, CollectivesTest, 4);
+BspTest1(Extra, 1, CollectivesTest, 1000);
+BspTest1(Extra, 3, CollectivesTest, 1000);
+BspTest1(Extra, 8, CollectivesTest, 1000);
+BspTest1(Extra, 3, CollectivesTest, 20000);
+BspTest1(Extra, 8, CollectivesTest, 20000);
+
+TEST(P(Extra), CollectivesScalar)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        const uint32_t target = (s + 1) % nProc;
+
+        uint32_t received = 0;
+        BSPLib::Push(received);
+        BSPLib::Sync();
+
+        // Collectives do not sync the pending puts
+        uint32_t sent = s;
+        BSPLib::Put(target, sent, received);
+
+        double value = s + 0.5;
+        EXPECT_DOUBLE_EQ(nProc * nProc / 2.0, BSPLib::Collectives::AllReduce(value));
+        EXPECT_DOUBLE_EQ(s == 2 ? nProc * nProc / 2.0 : value, BSPLib::Collectives::Reduce(value, 2));
+        EXPECT_DOUBLE_EQ((s + 1) * (s + 1) / 2.0, BSPLib::Collectives::InclusiveScan(value));
+        EXPECT_DOUBLE_EQ(s * s / 2.0, BSPLib::Collectives::ExclusiveScan(value, 0.0));
+        EXPECT_EQ(0u, received);
+
+        uint32_t rootValue = s * 7;
+        BSPLib::Collectives::Broadcast(rootValue, 3);
+        EXPECT_EQ(21u, rootValue);
+
+        std::vector< uint32_t > ids = BSPLib::Collectives::AllGather(s);
+        ASSERT_EQ(nProc, ids.size());
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            EXPECT_EQ(pid, ids[pid]);
+        }
+
+        // Values that cannot be copied bytewise are read by reference
+        std::string text = s == 1 ? "broadcast from processor one" : "";
+        BSPLib::Collectives::Broadcast(text, 1);
+        EXPECT_EQ("broadcast from processor one", text);
+
+        std::vector< std::string > texts = BSPLib::Collectives::AllGather(std::to_string(s));
+        EXPECT_EQ(std::to_string(nProc - 1), texts.back());
+
+        BSPLib::Sync();
+        EXPECT_EQ((s + nProc - 1) % nProc, received);
+
+        BSPLib::Pop(received);
+        BSPLib::Sync();
+    }, 4);
+}
+
+template< uint32_t tCount >
+void ReductionOperatorsTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    std::vector< float > values(tCount);
+    std::vector< uint32_t > bits(tCount);
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        values[i] = 0.1f * (s + 1) + i;
+        bits[i] = (1u << (s % 32)) | i;
+    }
+
+    std::vector< float > sums = values;
+    BSPLib::Collectives::AllReduce(sums);
+    std::vector< float > minima = values;
+    BSPLib::Collectives::AllReduce(minima, BSPLib::Collectives::Min< float >());
+    std::vector< float > maxima = values;
+    BSPLib::Collectives::AllReduce(maxima, BSPLib::Collectives::Max< float >());
+    std::vector< uint32_t > ors = bits;
+    BSPLib::Collectives::AllReduce(ors, BSPLib::Collectives::BitOr< uint32_t >());
+    std::vector< uint32_t > ands = bits;
+    BSPLib::Collectives::AllReduce(ands, BSPLib::Collectives::BitAnd< uint32_t >());
+    std::vector< uint32_t > xors = bits;
+    BSPLib::Collectives::Reduce(xors, nProc - 1, BSPLib::Collectives::BitXor< uint32_t >());
+
+    // Pairs are not arithmetic, and are combined with the generic kernel
+    std::vector< std::pair< uint32_t, uint32_t > > pairs(tCount, std::make_pair(s, s));
+    BSPLib::Collectives::InclusiveScan(pairs, [](const std::pair< uint32_t, uint32_t > &a,
+                                                 const std::pair< uint32_t, uint32_t > &b)
+    {
+        return std::make_pair(a.first + b.first, std::max(a.second, b.second));
+    });
+
+    for (uint32_t i = 0; i < tCount; ++i)
+    {
+        // The sum is combined in the order of the processors on every processor
+        float sum = 0.1f + i;
+        uint32_t orBits = 0;
+        uint32_t andBits = ~0u;
+        uint32_t xorBits = 0;
+
+        for (uint32_t pid = 1; pid < nProc; ++pid)
+        {
+            sum = sum + (0.1f * (pid + 1) + i);
+        }
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            const uint32_t value = (1u << (pid % 32)) | i;
+            orBits |= value;
+            andBits &= value;
+            xorBits ^= value;
+        }
+
+        EXPECT_EQ(sum, sums[i]) << i;
+        EXPECT_EQ(0.1f + i, minima[i]);
+        EXPECT_EQ(0.1f * nProc + i, maxima[i]);
+        EXPECT_EQ(orBits, ors[i]);
+        EXPECT_EQ(andBits, ands[i]);
+        EXPECT_EQ(s == nProc - 1 ? xorBits : bits[i], xors[i]);
+        EXPECT_EQ(s * (s + 1) / 2, pairs[i].first);
+        EXPECT_EQ(s, pairs[i].second);
+    }
+}
+
+BspTest1(Extra, 4, ReductionOperatorsTest, 3);
+BspTest1(Extra, 4, ReductionOperatorsTest, 300);
+BspTest1(Extra, 4, ReductionOperatorsTest, 10000);
+BspTest1(Extra, 7, ReductionOperatorsTest, 10007);
+
+TEST(P(Extra), AllToAllV)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+
+        // Processor s sends (s + pid) % 3 values to processor pid, which encode the pair and the index
+        std::vector< size_t > sendCounts(nProc);
+        std::vector< uint32_t > send;
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            sendCounts[pid] = (s + pid) % 3;
+
+            for (uint32_t i = 0; i < sendCounts[pid]; ++i)
+            {
+                send.push_back(s * 10000 + pid * 100 + i);
+            }
+        }
+
+        std::vector< uint32_t > expected;
+        std::vector< size_t > expectedCounts(nProc);
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            expectedCounts[pid] = (pid + s) % 3;
+
+            for (uint32_t i = 0; i < expectedCounts[pid]; ++i)
+            {
+                expected.push_back(pid * 10000 + s * 100 + i);
+            }
+        }
+
+        for (uint32_t round = 0; round < 3; ++round)
+        {
+            std::vector< uint32_t > recv(expected.size() + 1, 0xffffffff);
+            std::vector< size_t > recvCounts(nProc, 0);
+            BSPLib::Collectives::AllToAllV(send.data(), sendCounts.data(), recv.data(), recvCounts.data());
+
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), recv.begin()));
+            EXPECT_EQ(0xffffffff, recv.back());
+            EXPECT_EQ(expectedCounts, recvCounts);
+
+            std::vector< size_t > discoveredCounts;
+            EXPECT_EQ(expected, BSPLib::Collectives::AllToAllV(send, sendCounts, &discoveredCounts));
+            EXPECT_EQ(expectedCounts, discoveredCounts);
+        }
+
+        // Values that cannot be copied bytewise
+        std::vector< std::string > texts(nProc);
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            texts[pid] = std::to_string(s) + " to " + std::to_string(pid);
+        }
+
+        std::vector< std::string > received = BSPLib::Collectives::AllToAllV(texts, std::vector< size_t >(nProc, 1));
+        ASSERT_EQ(nProc, received.size());
+
+        for (uint32_t pid = 0; pid < nProc; ++pid)
+        {
+            EXPECT_EQ(std::to_string(pid) + " to " + std::to_string(s), received[pid]);
+        }
+    }, 5);
+}
+
+TEST(P(Extra), SparseExchange)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+
+        std::vector< std::vector< uint64_t > > send(nProc);
+        std::vector< uint64_t > recv;
+        std::vector< size_t > recvCounts;
+
+        for (uint32_t round = 0; round < 4; ++round)
+        {
+            // Every processor only sends to its neighbour and a processor that depends on the round
+            const uint32_t neighbour = (s + 1) % nProc;
+            const uint32_t other = (s * 3 + round) % nProc;
+
+            for (std::vector< uint64_t > &buffer : send)
+            {
+                buffer.clear();
+            }
+
+            for (uint32_t i = 0; i < s + round; ++i)
+            {
+                send[neighbour].push_back(s * 1000 + i);
+            }
+
+            send[other].push_back(1000000 + s);
+
+            BSPLib::Collectives::SparseExchange(send, recv, &recvCounts);
+
+            std::vector< uint64_t > expected;
+            std::vector< size_t > expectedCounts(nProc, 0);
+
+            for (uint32_t pid = 0; pid < nProc; ++pid)
+            {
+                if ((pid + 1) % nProc == s)
+                {
+                    for (uint32_t i = 0; i < pid + round; ++i)
+                    {
+                        expected.push_back(pid * 1000 + i);
+                        ++expectedCounts[pid];
+                    }
+                }
+
+                if ((pid * 3 + round) % nProc == s)
+                {
+                    expected.push_back(1000000 + pid);
+                    ++expectedCounts[pid];
+                }
+            }
+
+            EXPECT_EQ(expected, recv);
+            EXPECT_EQ(expectedCounts, recvCounts);
+        }
+
+        std::vector< std::vector< std::string > > texts(nProc);
+        texts[(s + 2) % nProc].push_back(std::to_string(s));
+        std::vector< std::string > received = BSPLib::Collectives::SparseExchange(texts);
+        ASSERT_EQ(1u, received.size());
+        EXPECT_EQ(std::to_string((s + nProc - 2) % nProc), received[0]);
+    }, 6);
+}
+
+TEST(P(Extra), SplitSync)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+        const uint32_t target = (s + 1) % nProc;
+        const uint32_t source = (s + nProc - 1) % nProc;
+
+        std::vector< uint32_t > halo(4, 0);
+        std::vector< uint32_t > interior(4, 0);
+        BSPLib::Register< uint32_t > haloReg = BSPLib::PushPtrs(halo.data(), halo.size());
+        uint32_t shared = s * 7;
+        BSPLib::Push(shared);
+        BSPLib::SyncBegin();
+        BSPLib::SyncEnd();
+
+        size_t tagSize = sizeof(uint32_t);
+        BSPLib::Classic::SetTagSize(&tagSize);
+        BSPLib::Sync();
+
+        for (uint32_t superstep = 0; superstep < 6; ++superstep)
+        {
+            for (uint32_t i = 0; i < halo.size(); ++i)
+            {
+                const uint32_t value = s * 100 + i + superstep;
+                BSPLib::Put(target, value, haloReg, i);
+            }
+
+            uint32_t fetched = 0;
+            BSPLib::Get(target, shared, fetched);
+            BSPLib::Send(target, superstep, s + superstep);
+
+            // Alternate with normal syncs, which use another barrier
+            if (superstep % 3 == 2)
+            {
+                BSPLib::Sync();
+            }
+            else
+            {
+                BSPLib::SyncBegin();
+
+                // Imbalanced local work that does not touch the communicated memory
+                if (s == superstep % nProc)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+
+                for (uint32_t &value : interior)
+                {
+                    value += s;
+                }
+
+                BSPLib::SyncEnd();
+            }
+
+            for (uint32_t i = 0; i < halo.size(); ++i)
+            {
+                EXPECT_EQ(source * 100 + i + superstep, halo[i]);
+            }
+
+            EXPECT_EQ(target * 7, fetched);
+
+            size_t packets = 0;
+            size_t accumulatedSize = 0;
+            BSPLib::Classic::QSize(&packets, &accumulatedSize);
+            ASSERT_EQ(1u, packets);
+
+            uint32_t tag = 0;
+            uint32_t message = 0;
+            BSPLib::Classic::GetTag(&accumulatedSize, &tag);
+            BSPLib::Move(message);
+            EXPECT_EQ(superstep, tag);
+            EXPECT_EQ(source + superstep, message);
+        }
+
+        BSPLib::Pop(shared);
+        BSPLib::Pop(haloReg);
+        BSPLib::SyncBegin();
+        BSPLib::SyncEnd();
+    }, 4);
+}
+
+TEST(P(Extra), SplitSyncDeliversPutsAndSends)
+{
+    BSPLib::Execute([]
+    {
+        const uint32_t s = BSPLib::ProcId();
+        const uint32_t nProc = BSPLib::NProcs();
+
+        std::vector< uint32_t > received(nProc, 0);
+        std::vector< uint32_t > last(1, 0);
+        BSPLib::Register< uint32_t > receivedReg = BSPLib::PushPtrs(received.data(), received.size());
+        BSPLib::Register< uint32_t > lastReg = BSPLib::PushPtrs(last.data(), last.size());
+        BSPLib::Sync();
+
+        for (uint32_t superstep = 0; superstep < 20; ++superstep)
+        {
+            for (uint32_t target = 0; target < nProc; ++target)
+            {
+                BSPLib::Put(target, s * 1000 + superstep, receivedReg, s);
+                BSPLib::Send(target, s + superstep);
+
+                // The last put to a location wins, also when another processor delivers it
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    BSPLib::Put(target, s * 100 + superstep * 3 + i, lastReg, 0);
+                }
+            }
+
+            BSPLib::SyncBegin();
+
+            // A few processors work much longer, so the others deliver for them
+            if ((s + superstep) % 3 == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+
+            BSPLib::SyncEnd();
+
+            for (uint32_t source = 0; source < nProc; ++source)
+            {
+                EXPECT_EQ(source * 1000 + superstep, received[source]);
+            }
+
+            EXPECT_EQ(superstep * 3 + 2, last[0] % 100);
+
+            size_t packets = 0;
+            BSPLib::Classic::QSize(&packets, nullptr);
+            ASSERT_EQ(nProc, packets);
+
+            std::vector< uint32_t > messages(nProc, 0);
+
+            for (uint32_t &message : messages)
+            {
+                BSPLib::Move(message);
+            }
+
+            std::sort(messages.begin(), messages.end());
+
+            for (uint32_t source = 0; source < nProc; ++source)
+            {
+                EXPECT_EQ(source + superstep, messages[source]);
+            }
+        }
+
+        BSPLib::Pop(receivedReg);
+        BSPLib::Pop(lastReg);
+        BSPLib::Sync();
+    }, 8);
+}
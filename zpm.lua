@@ -33,6 +33,29 @@ workspace "BSPLib"
         mayLink = false
     } )
 
+    -- The barrier is fixed at compile time, so the tests run again in their own binary for the other barriers
+    for _, barrier in ipairs( { "TreeBarrier", "FutexBarrier" } ) do
+
+        project( "bsp-test-" .. barrier:lower() )
+            kind "ConsoleApp"
+
+            zpm.uses "Zefiros-Software/GoogleTest"
+
+            includedirs { "bsp/include", "test" }
+
+            defines {
+                "PREFIX=" .. barrier .. "_",
+                "BSP_BARRIER_TYPE=BSPInternal::" .. barrier
+            }
+
+            files "test/*.cpp"
+
+            filter "system:not windows"
+                links "pthread"
+
+            filter {}
+    end
+
 
 workspace "BSPEdupack"
 